@@ -0,0 +1,206 @@
+// every operation of big_integer next to the same one of big_integer_gmp, for operands
+// from 1 to 10^6 limbs. results go to the console and, as json, to bench.json:
+//   bench [--benchmark_filter=mul] [--benchmark_out=file.json]
+#include <cstddef>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include <benchmark/benchmark.h>
+
+#include "../big_integer.h"
+#include "../ci-extra/big_integer_gmp.h"
+
+namespace
+{
+    // random number of at most this many limbs, made once for every type, size and seed
+    template <typename T>
+    T const& operand(size_t limbs, unsigned seed)
+    {
+        static std::map<std::pair<size_t, unsigned>, T> cache;
+        auto it = cache.find({limbs, seed});
+        if (it == cache.end())
+        {
+            std::mt19937 rng(seed * 1000003u + static_cast<unsigned>(limbs));
+            big_integer_gmp x;
+            x.random(64 * limbs - 1, rng);
+            it = cache.emplace(std::make_pair(limbs, seed), T(to_string(x))).first;
+        }
+        return it->second;
+    }
+
+    template <typename T>
+    void add(benchmark::State& state)
+    {
+        T const& a = operand<T>(state.range(0), 1);
+        T const& b = operand<T>(state.range(0), 2);
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(a + b);
+        }
+    }
+
+    template <typename T>
+    void sub(benchmark::State& state)
+    {
+        T const& a = operand<T>(state.range(0), 1);
+        T const& b = operand<T>(state.range(0), 2);
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(a - b);
+        }
+    }
+
+    template <typename T>
+    void mul(benchmark::State& state)
+    {
+        T const& a = operand<T>(state.range(0), 1);
+        T const& b = operand<T>(state.range(0), 2);
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(a * b);
+        }
+    }
+
+    // the dividend is twice as long as the divisor
+    template <typename T>
+    void div(benchmark::State& state)
+    {
+        T const& a = operand<T>(2 * state.range(0), 1);
+        T const& b = operand<T>(state.range(0), 2);
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(a / b);
+        }
+    }
+
+    template <typename T>
+    void mod(benchmark::State& state)
+    {
+        T const& a = operand<T>(2 * state.range(0), 1);
+        T const& b = operand<T>(state.range(0), 2);
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(a % b);
+        }
+    }
+
+    template <typename T>
+    void bit_and(benchmark::State& state)
+    {
+        T const& a = operand<T>(state.range(0), 1);
+        T const& b = operand<T>(state.range(0), 2);
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(a & b);
+        }
+    }
+
+    template <typename T>
+    void bit_or(benchmark::State& state)
+    {
+        T const& a = operand<T>(state.range(0), 1);
+        T const& b = operand<T>(state.range(0), 2);
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(a | b);
+        }
+    }
+
+    template <typename T>
+    void bit_xor(benchmark::State& state)
+    {
+        T const& a = operand<T>(state.range(0), 1);
+        T const& b = operand<T>(state.range(0), 2);
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(a ^ b);
+        }
+    }
+
+    // shifts are by half of the length and a few bits
+    template <typename T>
+    void shl(benchmark::State& state)
+    {
+        T const& a = operand<T>(state.range(0), 1);
+        int bits = static_cast<int>(32 * state.range(0) + 7);
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(a << bits);
+        }
+    }
+
+    template <typename T>
+    void shr(benchmark::State& state)
+    {
+        T const& a = operand<T>(state.range(0), 1);
+        int bits = static_cast<int>(32 * state.range(0) + 7);
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(a >> bits);
+        }
+    }
+
+    template <typename T>
+    void to_decimal(benchmark::State& state)
+    {
+        T const& a = operand<T>(state.range(0), 1);
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(to_string(a));
+        }
+    }
+
+    template <typename T>
+    void from_decimal(benchmark::State& state)
+    {
+        std::string s = to_string(operand<T>(state.range(0), 1));
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(T(s));
+        }
+    }
+
+    void sizes(benchmark::internal::Benchmark* b)
+    {
+        b->RangeMultiplier(10)->Range(1, 1000000)->Unit(benchmark::kMicrosecond);
+    }
+} // namespace
+
+// both implementations side by side, so that the ratio is read from neighbouring lines
+#define BENCHMARK_BOTH(op)                                  \
+    BENCHMARK_TEMPLATE(op, big_integer)->Apply(sizes);      \
+    BENCHMARK_TEMPLATE(op, big_integer_gmp)->Apply(sizes)
+
+BENCHMARK_BOTH(add);
+BENCHMARK_BOTH(sub);
+BENCHMARK_BOTH(mul);
+BENCHMARK_BOTH(div);
+BENCHMARK_BOTH(mod);
+BENCHMARK_BOTH(bit_and);
+BENCHMARK_BOTH(bit_or);
+BENCHMARK_BOTH(bit_xor);
+BENCHMARK_BOTH(shl);
+BENCHMARK_BOTH(shr);
+BENCHMARK_BOTH(to_decimal);
+BENCHMARK_BOTH(from_decimal);
+
+int main(int argc, char** argv)
+{
+    // json goes to bench.json unless the command line says otherwise
+    std::vector<char*> args = {argv[0]};
+    char out[] = "--benchmark_out=bench.json";
+    char format[] = "--benchmark_out_format=json";
+    args.push_back(out);
+    args.push_back(format);
+    args.insert(args.end(), argv + 1, argv + argc);
+    int count = static_cast<int>(args.size());
+    benchmark::Initialize(&count, args.data());
+    if (benchmark::ReportUnrecognizedArguments(count, args.data()))
+    {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+}
@@ -0,0 +1,73 @@
+// scaling of the parallel multiplication with the number of threads
+// usage: mul_scaling [limbs] [max threads] [threshold]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+
+#include "../big_integer.h"
+
+namespace
+{
+    // random number of n limbs, glued from halves so that it takes O(M(n) log n)
+    big_integer random_limbs(size_t n, std::mt19937_64& rng)
+    {
+        if (n == 1)
+        {
+            return big_integer(static_cast<unsigned long long>(rng()));
+        }
+        size_t h = n / 2;
+        big_integer lo = random_limbs(h, rng);
+        return (random_limbs(n - h, rng) << static_cast<int>(64 * h)) | lo;
+    }
+
+    // best of a few runs, in milliseconds
+    double time_mul(big_integer const& a, big_integer const& b)
+    {
+        double best = 1e300;
+        for (int run = 0; run < 3; run++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            big_integer c = a * b;
+            auto finish = std::chrono::steady_clock::now();
+            best = std::min(best, std::chrono::duration<double, std::milli>(finish - start).count());
+        }
+        return best;
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    size_t limbs = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000);
+    unsigned max_threads = (argc > 2 ? std::atoi(argv[2]) : std::thread::hardware_concurrency());
+    max_threads = std::max(max_threads, 1u);
+    if (argc > 3)
+    {
+        set_parallel_threshold(std::strtoull(argv[3], nullptr, 10));
+    }
+
+    std::mt19937_64 rng(12345);
+    big_integer a = random_limbs(limbs, rng);
+    big_integer b = random_limbs(limbs, rng);
+
+    std::printf("%zu limbs\n%8s %12s %8s\n", limbs, "threads", "ms", "speedup");
+    double single = 0;
+    // 1, 2, 4, ... threads and the maximum
+    for (unsigned threads = 1;; threads = std::min(2 * threads, max_threads))
+    {
+        set_multiplication_threads(threads);
+        double t = time_mul(a, b);
+        if (threads == 1)
+        {
+            single = t;
+        }
+        std::printf("%8u %12.2f %8.2f\n", threads, t, single / t);
+        if (threads == max_threads)
+        {
+            break;
+        }
+    }
+    set_multiplication_threads(1);
+}
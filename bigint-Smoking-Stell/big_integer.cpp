@@ -1,303 +1,3714 @@
 #include "big_integer.h"
 #include <algorithm>
+#include <cmath>
+#include <condition_variable>
 #include <cstddef>
 #include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <ostream>
 #include <stdexcept>
+#include <thread>
+#include <vector>
+
+#ifdef BIG_INTEGER_STATS
+#include <atomic>
+#endif
+
+// BIG_INTEGER_GENERIC_KERNELS keeps the portable kernels on any machine, so that they can be
+// tested where the others would be picked
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(BIG_INTEGER_GENERIC_KERNELS)
+#define BIG_INTEGER_X86_KERNELS
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
 
 // module + sign
 
-static const uint64_t base = (UINT32_MAX + 1ul);
-static const uint32_t DI = 10;
+__extension__ typedef unsigned __int128 uint128_t;
+
+static const unsigned LIMB_BITS = 64;
+static const limb_t LIMB_MAX = ~static_cast<limb_t>(0);
+// decimal conversions work with chunks of nineteen digits
+static const limb_t DEC_BASE = 10000000000000000000u;
+static const size_t DEC_DIGITS = 19;
+
+// below this length (in limbs) of the shorter operand schoolbook multiplication is faster
+static const size_t KARATSUBA_THRESHOLD = 32;
+static const size_t SQR_KARATSUBA_THRESHOLD = 48;
+// the same for karatsuba against toom-3 and toom-3 against toom-4
+static const size_t TOOM3_THRESHOLD = 50;
+static const size_t TOOM4_THRESHOLD = 200;
+// from here the three-prime number theoretic transform takes over
+static const size_t NTT_THRESHOLD = 15000;
+// divisors (and quotients) from this length are divided by burnikel-ziegler recursion
+static const size_t BZ_THRESHOLD = 80;
+// and from this length through the newton reciprocal
+static const size_t NEWTON_THRESHOLD = 4000;
+// numbers from this length are converted to decimal by halves
+static const size_t TO_STRING_THRESHOLD = 20;
+// and from decimal
+static const size_t FROM_STRING_THRESHOLD = 20;
+// products with the shorter operand of this many limbs split between threads, if they are on
+static const size_t PARALLEL_THRESHOLD = 2000;
+// montgomery reduction by moduli of this length goes by two products instead of limb by limb
+static const size_t REDC_THRESHOLD = 800;
+// barrett_reducer keeps the reciprocal of moduli from this length, shorter ones are divided directly
+static const size_t BARRETT_THRESHOLD = 1500;
+// gcd of numbers from this length goes by the half-gcd recursion, shorter ones by lehmer's steps
+static const size_t HGCD_THRESHOLD = 100;
+
+#ifdef BIG_INTEGER_STATS
+// counters of one thread. only the owner writes them, get_stats reads them from any thread
+struct thread_stats {
+    thread_stats();
+    ~thread_stats();
+
+    std::atomic<uint64_t> allocations[big_integer_stats::OPERATIONS] = {};
+    std::atomic<uint64_t> allocated_bytes[big_integer_stats::OPERATIONS] = {};
+    std::atomic<uint64_t> tiers[big_integer_stats::TIERS] = {};
+    std::atomic<uint64_t> mul_longer[big_integer_stats::BUCKETS] = {};
+    std::atomic<uint64_t> mul_shorter[big_integer_stats::BUCKETS] = {};
+    std::atomic<uint64_t> div_dividend[big_integer_stats::BUCKETS] = {};
+    std::atomic<uint64_t> div_divisor[big_integer_stats::BUCKETS] = {};
+};
+
+// f(x, y) for all matching arrays of counters of a and b
+template <typename A, typename B, typename F>
+static void for_each_counters(A& a, B& b, F f) {
+    f(a.allocations, b.allocations);
+    f(a.allocated_bytes, b.allocated_bytes);
+    f(a.tiers, b.tiers);
+    f(a.mul_longer, b.mul_longer);
+    f(a.mul_shorter, b.mul_shorter);
+    f(a.div_dividend, b.div_dividend);
+    f(a.div_divisor, b.div_divisor);
+}
+
+static uint64_t counter_value(uint64_t x) {
+    return x;
+}
+
+static uint64_t counter_value(std::atomic<uint64_t> const& x) {
+    return x.load(std::memory_order_relaxed);
+}
+
+// to += from, for the totals and for the counters of a thread
+template <typename T>
+static void add_stats(big_integer_stats& to, T const& from) {
+    for_each_counters(to, from, [](auto& x, auto const& y) {
+        for (size_t i = 0; i < sizeof(x) / sizeof(x[0]); i++) {
+            x[i] += counter_value(y[i]);
+        }
+    });
+}
+
+// live threads, the counts of finished ones and the totals at the last reset
+struct stats_registry {
+    std::mutex mutex;
+    std::vector<thread_stats const*> threads;
+    big_integer_stats finished = {};
+    big_integer_stats baseline = {};
+};
+
+// never destroyed: the workers of mul_pool, a static that goes after it, still give their counts
+// back at exit
+static stats_registry& registry() {
+    static stats_registry* r = new stats_registry;
+    return *r;
+}
+
+thread_stats::thread_stats() {
+    stats_registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.threads.push_back(this);
+}
+
+thread_stats::~thread_stats() {
+    stats_registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    add_stats(r.finished, *this);
+    r.threads.erase(std::find(r.threads.begin(), r.threads.end(), this));
+}
+
+static thread_local thread_stats local_stats;
+static thread_local big_integer_stats::operation current_operation = big_integer_stats::OTHER;
+
+// the operation the allocations are counted for, nested operations keep the outer one
+struct operation_scope {
+    explicit operation_scope(big_integer_stats::operation op) : saved(current_operation) {
+        if (saved == big_integer_stats::OTHER) {
+            current_operation = op;
+        }
+    }
+
+    ~operation_scope() {
+        current_operation = saved;
+    }
+
+    big_integer_stats::operation saved;
+};
+
+// only the owner thread writes, so the increment doesn't need to be atomic as a whole
+static void bump(std::atomic<uint64_t>& c, uint64_t x = 1) {
+    c.store(c.load(std::memory_order_relaxed) + x, std::memory_order_relaxed);
+}
+
+static void count_allocation(size_t limbs) {
+    bump(local_stats.allocations[current_operation]);
+    bump(local_stats.allocated_bytes[current_operation], limbs * sizeof(limb_t));
+}
+
+static size_t length_bucket(size_t n) {
+    size_t k = 0;
+    for (; n > 0; n >>= 1u) {
+        k++;
+    }
+    return k;
+}
+
+static void count_lengths(std::atomic<uint64_t>* longer, std::atomic<uint64_t>* shorter, size_t n, size_t m) {
+    bump(longer[length_bucket(std::max(n, m))]);
+    bump(shorter[length_bucket(std::min(n, m))]);
+}
+
+big_integer_stats get_stats() {
+    stats_registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    big_integer_stats res = r.finished;
+    for (thread_stats const* t : r.threads) {
+        add_stats(res, *t);
+    }
+    for_each_counters(res, r.baseline, [](auto& x, auto const& y) {
+        for (size_t i = 0; i < sizeof(x) / sizeof(x[0]); i++) {
+            x[i] -= y[i];
+        }
+    });
+    return res;
+}
+
+// counters of other threads can't be cleared safely, the current totals are remembered instead
+void reset_stats() {
+    big_integer_stats now = get_stats();
+    stats_registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    add_stats(r.baseline, now);
+}
+
+#define STATS_OPERATION(op) operation_scope stats_scope(big_integer_stats::op)
+#define STATS_TIER(t) bump(local_stats.tiers[big_integer_stats::t])
+#define STATS_ALLOCATION(limbs) count_allocation(limbs)
+#define STATS_MUL(n, m) count_lengths(local_stats.mul_longer, local_stats.mul_shorter, n, m)
+#define STATS_DIV(n, m) count_lengths(local_stats.div_dividend, local_stats.div_divisor, n, m)
+#else
+#define STATS_OPERATION(op) ((void)0)
+#define STATS_TIER(t) ((void)0)
+#define STATS_ALLOCATION(limbs) ((void)0)
+#define STATS_MUL(n, m) ((void)0)
+#define STATS_DIV(n, m) ((void)0)
+#endif
+
+// temporary limbs for the recursive algorithms, used as a stack:
+// memory is taken in blocks which never move, so given pointers stay valid
+class limb_stack {
+public:
+    struct mark_t {
+        size_t block;
+        size_t used;
+    };
+
+    limb_t* take(size_t len) {
+        while (cur < blocks.size() && blocks[cur].size - blocks[cur].used < len) {
+            if (blocks[cur].used == 0) {
+                // nothing lives here, so the block can be replaced by a bigger one
+                blocks[cur].data.reset(new limb_t[len]);
+                STATS_ALLOCATION(len);
+                blocks[cur].size = len;
+                break;
+            }
+            cur++;
+        }
+        if (cur == blocks.size()) {
+            size_t size = std::max(len, blocks.empty() ? MIN_BLOCK : 2 * blocks.back().size);
+            blocks.push_back({std::unique_ptr<limb_t[]>(new limb_t[size]), size, 0});
+            STATS_ALLOCATION(size);
+        }
+        limb_t* res = blocks[cur].data.get() + blocks[cur].used;
+        blocks[cur].used += len;
+        return res;
+    }
+
+    mark_t mark() const {
+        return {cur, cur < blocks.size() ? blocks[cur].used : 0};
+    }
+
+    void release(mark_t m) {
+        for (size_t i = m.block + 1; i <= cur && i < blocks.size(); i++) {
+            blocks[i].used = 0;
+        }
+        cur = m.block;
+        if (cur < blocks.size()) {
+            blocks[cur].used = m.used;
+        }
+    }
+
+private:
+    static const size_t MIN_BLOCK = 1024;
+
+    struct block {
+        std::unique_ptr<limb_t[]> data;
+        size_t size;
+        size_t used;
+    };
+
+    std::vector<block> blocks;
+    size_t cur = 0;
+};
+
+static thread_local limb_stack scratch;
+
+// gives back everything taken from scratch during its lifetime
+struct scratch_frame {
+    scratch_frame() : m(scratch.mark()) {
+    }
+
+    ~scratch_frame() {
+        scratch.release(m);
+    }
+
+    limb_stack::mark_t m;
+};
+
+// workers for the multiplication of huge numbers. all tasks are kept in one deque: a thread
+// waiting for its group takes the newest tasks, which are usually its own, while idle workers
+// steal the oldest ones, which are the biggest. the waiting thread keeps working, so groups
+// may be nested without deadlocks
+class thread_pool {
+public:
+    struct group {
+        size_t pending = 0;
+        std::exception_ptr error;
+    };
+
+    explicit thread_pool(unsigned workers) {
+        for (unsigned i = 0; i < workers; i++) {
+            threads.emplace_back([this] { work(); });
+        }
+    }
+
+    ~thread_pool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        cv.notify_all();
+        for (std::thread& t : threads) {
+            t.join();
+        }
+    }
+
+    void submit(group& g, std::function<void()> f) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            g.pending++;
+            tasks.push_back({&g, std::move(f)});
+        }
+        cv.notify_one();
+    }
+
+    // runs queued tasks until every task of g is done, then rethrows the first error of g
+    void wait(group& g) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (g.pending > 0) {
+            if (tasks.empty()) {
+                cv.wait(lock);
+                continue;
+            }
+            task t = std::move(tasks.back());
+            tasks.pop_back();
+            run(t, lock);
+        }
+        if (g.error) {
+            std::rethrow_exception(g.error);
+        }
+    }
+
+private:
+    struct task {
+        group* g;
+        std::function<void()> f;
+    };
+
+    void run(task& t, std::unique_lock<std::mutex>& lock) {
+        lock.unlock();
+        std::exception_ptr error;
+        try {
+            t.f();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        lock.lock();
+        if (error && !t.g->error) {
+            t.g->error = error;
+        }
+        if (--t.g->pending == 0) {
+            cv.notify_all();
+        }
+    }
+
+    void work() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            if (!tasks.empty()) {
+                task t = std::move(tasks.front());
+                tasks.pop_front();
+                run(t, lock);
+            } else if (stop) {
+                return;
+            } else {
+                cv.wait(lock);
+            }
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<task> tasks;
+    std::vector<std::thread> threads;
+    bool stop = false;
+};
+
+// null while all work stays on the calling thread
+static std::unique_ptr<thread_pool> mul_pool;
+static size_t parallel_threshold = PARALLEL_THRESHOLD;
+
+// whether a product with the shorter operand of this length is split between threads
+static bool use_threads(size_t limbs) {
+    return mul_pool != nullptr && limbs >= parallel_threshold;
+}
+
+// f(0), ..., f(count - 1), with `parallel` the calls go to the pool and may run at the same time
+template <typename F>
+static void parallel_for(size_t count, bool parallel, F const& f) {
+    if (!parallel || mul_pool == nullptr || count < 2) {
+        for (size_t i = 0; i < count; i++) {
+            f(i);
+        }
+        return;
+    }
+    thread_pool::group g;
+    for (size_t i = 0; i < count; i++) {
+#ifdef BIG_INTEGER_STATS
+        mul_pool->submit(g, [&f, i, op = current_operation] {
+            operation_scope scope(op);
+            f(i);
+        });
+#else
+        mul_pool->submit(g, [&f, i] { f(i); });
+#endif
+    }
+    mul_pool->wait(g);
+}
+
+// f(begin, end) for the consecutive pieces of [0, n) of the given length
+template <typename F>
+static void parallel_ranges(size_t n, size_t piece, bool parallel, F const& f) {
+    parallel_for((n + piece - 1) / piece, parallel, [&](size_t i) {
+        f(i * piece, std::min(n, (i + 1) * piece));
+    });
+}
+
+// kernels on limbs, the inner loops of multiplication and division. the set is chosen once at startup:
+// x86-64 processors with bmi2 and adx get the versions built on mulx and two carry chains
+
+// r[0..n] = a[0..n] + b[0..n], returns carry, r may be a or b
+typedef limb_t (*add_n_fn)(limb_t* r, limb_t const* a, limb_t const* b, size_t n);
+// r[0..n] = a[0..n] - b[0..n], returns borrow, r may be a or b
+typedef limb_t (*sub_n_fn)(limb_t* r, limb_t const* a, limb_t const* b, size_t n);
+// r[0..n] = a[0..n] * b, returns the high limb, r may be a
+typedef limb_t (*mul_1_fn)(limb_t* r, limb_t const* a, size_t n, limb_t b);
+// r[0..n] += a[0..n] * b, returns the high limb, r doesn't overlap a
+typedef limb_t (*addmul_1_fn)(limb_t* r, limb_t const* a, size_t n, limb_t b);
+// r[0..n] -= a[0..n] * b, returns the high limb to subtract, r doesn't overlap a
+typedef limb_t (*submul_1_fn)(limb_t* r, limb_t const* a, size_t n, limb_t b);
+// r[0..n+m] = a[0..n] * b[0..m], n >= m >= 1, r doesn't overlap a and b
+typedef void (*mul_basecase_fn)(limb_t* r, limb_t const* a, size_t n, limb_t const* b, size_t m);
+
+struct limb_kernels {
+    add_n_fn add_n;
+    sub_n_fn sub_n;
+    mul_1_fn mul_1;
+    addmul_1_fn addmul_1;
+    submul_1_fn submul_1;
+    mul_basecase_fn mul_basecase;
+};
+
+static limb_t add_n_generic(limb_t* r, limb_t const* a, limb_t const* b, size_t n) {
+    limb_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        limb_t s = a[i] + carry;
+        carry = (s < carry);
+        r[i] = s + b[i];
+        carry += (r[i] < s);
+    }
+    return carry;
+}
+
+static limb_t sub_n_generic(limb_t* r, limb_t const* a, limb_t const* b, size_t n) {
+    limb_t borrow = 0;
+    for (size_t i = 0; i < n; i++) {
+        limb_t x = a[i];
+        limb_t d = x - b[i];
+        limb_t next = (d > x);
+        r[i] = d - borrow;
+        borrow = next + (r[i] > d);
+    }
+    return borrow;
+}
+
+static limb_t mul_1_generic(limb_t* r, limb_t const* a, size_t n, limb_t b) {
+    limb_t hi = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint128_t x = static_cast<uint128_t>(a[i]) * b + hi;
+        r[i] = static_cast<limb_t>(x);
+        hi = static_cast<limb_t>(x >> LIMB_BITS);
+    }
+    return hi;
+}
+
+static limb_t addmul_1_generic(limb_t* r, limb_t const* a, size_t n, limb_t b) {
+    limb_t hi = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint128_t x = static_cast<uint128_t>(a[i]) * b + r[i] + hi;
+        r[i] = static_cast<limb_t>(x);
+        hi = static_cast<limb_t>(x >> LIMB_BITS);
+    }
+    return hi;
+}
+
+static limb_t submul_1_generic(limb_t* r, limb_t const* a, size_t n, limb_t b) {
+    limb_t hi = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint128_t x = static_cast<uint128_t>(a[i]) * b + hi;
+        limb_t lo = static_cast<limb_t>(x);
+        hi = static_cast<limb_t>(x >> LIMB_BITS) + (r[i] < lo);
+        r[i] -= lo;
+    }
+    return hi;
+}
+
+static void mul_basecase_generic(limb_t* r, limb_t const* a, size_t n, limb_t const* b, size_t m) {
+    r[n] = mul_1_generic(r, a, n, b[0]);
+    for (size_t j = 1; j < m; j++) {
+        r[n + j] = addmul_1_generic(r + j, a, n, b[j]);
+    }
+}
+
+#ifdef BIG_INTEGER_X86_KERNELS
+
+static limb_t add_n_x86(limb_t* r, limb_t const* a, limb_t const* b, size_t n) {
+    unsigned char carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        unsigned long long s;
+        carry = _addcarry_u64(carry, a[i], b[i], &s);
+        r[i] = s;
+    }
+    return carry;
+}
+
+static limb_t sub_n_x86(limb_t* r, limb_t const* a, limb_t const* b, size_t n) {
+    unsigned char borrow = 0;
+    for (size_t i = 0; i < n; i++) {
+        unsigned long long d;
+        borrow = _subborrow_u64(borrow, a[i], b[i], &d);
+        r[i] = d;
+    }
+    return borrow;
+}
+
+__attribute__((target("bmi2,adx")))
+static limb_t mul_1_mulx(limb_t* r, limb_t const* a, size_t n, limb_t b) {
+    unsigned long long hi = 0;
+    unsigned char carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        unsigned long long h;
+        unsigned long long lo = _mulx_u64(a[i], b, &h);
+        carry = _addcarry_u64(carry, lo, hi, &lo);
+        r[i] = lo;
+        hi = h;
+    }
+    return hi + carry;
+}
+
+// the product a[i] * b is split by mulx without touching the flags: its high half is added to
+// the next low half on the OF chain (adox), the sums go into r on the CF chain (adcx).
+// the loop takes four limbs a time, the counter runs from -n up to zero by lea and jrcxz,
+// which leave both chains alone. the limbs beyond a multiple of four are done first
+__attribute__((target("bmi2,adx")))
+static limb_t addmul_1_adx(limb_t* r, limb_t const* a, size_t n, limb_t b) {
+    size_t head = n % 4;
+    limb_t hi = addmul_1_generic(r, a, head, b);
+    if (head == n) {
+        return hi;
+    }
+    limb_t lo;
+    limb_t t;
+    limb_t i = 0 - static_cast<limb_t>(n - head);
+    __asm__ volatile(
+            "xor %k[lo], %k[lo]\n\t"
+            "1:\n\t"
+            "mulx (%[a],%[i],8), %[lo], %[t]\n\t"
+            "adox %[hi], %[lo]\n\t"
+            "adcx (%[r],%[i],8), %[lo]\n\t"
+            "mov %[lo], (%[r],%[i],8)\n\t"
+            "mulx 8(%[a],%[i],8), %[lo], %[hi]\n\t"
+            "adox %[t], %[lo]\n\t"
+            "adcx 8(%[r],%[i],8), %[lo]\n\t"
+            "mov %[lo], 8(%[r],%[i],8)\n\t"
+            "mulx 16(%[a],%[i],8), %[lo], %[t]\n\t"
+            "adox %[hi], %[lo]\n\t"
+            "adcx 16(%[r],%[i],8), %[lo]\n\t"
+            "mov %[lo], 16(%[r],%[i],8)\n\t"
+            "mulx 24(%[a],%[i],8), %[lo], %[hi]\n\t"
+            "adox %[t], %[lo]\n\t"
+            "adcx 24(%[r],%[i],8), %[lo]\n\t"
+            "mov %[lo], 24(%[r],%[i],8)\n\t"
+            "lea 4(%[i]), %[i]\n\t"
+            "jrcxz 2f\n\t"
+            "jmp 1b\n\t"
+            "2:\n\t"
+            "mov $0, %k[lo]\n\t"
+            "adox %[lo], %[hi]\n\t"
+            "adcx %[lo], %[hi]\n\t"
+            : [hi] "+&r"(hi), [lo] "=&r"(lo), [t] "=&r"(t), [i] "+&c"(i)
+            : [a] "r"(a + n), [r] "r"(r + n), "d"(b)
+            : "cc", "memory");
+    return hi;
+}
+
+// as addmul_1_adx, but r - p is taken as r + ~p + 1: the complemented sums go into r on
+// the CF chain started with a carry, and the missing carry out is the borrow.
+// sbb would break the OF chain, adcx and not leave it alone
+__attribute__((target("bmi2,adx")))
+static limb_t submul_1_adx(limb_t* r, limb_t const* a, size_t n, limb_t b) {
+    size_t head = n % 4;
+    limb_t hi = submul_1_generic(r, a, head, b);
+    if (head == n) {
+        return hi;
+    }
+    limb_t lo;
+    limb_t t;
+    limb_t i = 0 - static_cast<limb_t>(n - head);
+    __asm__ volatile(
+            "xor %k[lo], %k[lo]\n\t"
+            "stc\n\t"
+            "1:\n\t"
+            "mulx (%[a],%[i],8), %[lo], %[t]\n\t"
+            "adox %[hi], %[lo]\n\t"
+            "not %[lo]\n\t"
+            "adcx (%[r],%[i],8), %[lo]\n\t"
+            "mov %[lo], (%[r],%[i],8)\n\t"
+            "mulx 8(%[a],%[i],8), %[lo], %[hi]\n\t"
+            "adox %[t], %[lo]\n\t"
+            "not %[lo]\n\t"
+            "adcx 8(%[r],%[i],8), %[lo]\n\t"
+            "mov %[lo], 8(%[r],%[i],8)\n\t"
+            "mulx 16(%[a],%[i],8), %[lo], %[t]\n\t"
+            "adox %[hi], %[lo]\n\t"
+            "not %[lo]\n\t"
+            "adcx 16(%[r],%[i],8), %[lo]\n\t"
+            "mov %[lo], 16(%[r],%[i],8)\n\t"
+            "mulx 24(%[a],%[i],8), %[lo], %[hi]\n\t"
+            "adox %[t], %[lo]\n\t"
+            "not %[lo]\n\t"
+            "adcx 24(%[r],%[i],8), %[lo]\n\t"
+            "mov %[lo], 24(%[r],%[i],8)\n\t"
+            "lea 4(%[i]), %[i]\n\t"
+            "jrcxz 2f\n\t"
+            "jmp 1b\n\t"
+            "2:\n\t"
+            "mov $0, %k[lo]\n\t"
+            "adox %[lo], %[hi]\n\t"
+            "cmc\n\t"
+            "adcx %[lo], %[hi]\n\t"
+            : [hi] "+&r"(hi), [lo] "=&r"(lo), [t] "=&r"(t), [i] "+&c"(i)
+            : [a] "r"(a + n), [r] "r"(r + n), "d"(b)
+            : "cc", "memory");
+    return hi;
+}
+
+__attribute__((target("bmi2,adx")))
+static void mul_basecase_adx(limb_t* r, limb_t const* a, size_t n, limb_t const* b, size_t m) {
+    r[n] = mul_1_mulx(r, a, n, b[0]);
+    for (size_t j = 1; j < m; j++) {
+        r[n + j] = addmul_1_adx(r + j, a, n, b[j]);
+    }
+}
+
+static bool has_bmi2_adx() {
+    unsigned eax;
+    unsigned ebx;
+    unsigned ecx;
+    unsigned edx;
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    return (ebx & bit_BMI2) != 0 && (ebx & bit_ADX) != 0;
+}
+
+#endif
+
+static limb_kernels select_kernels() {
+#ifdef BIG_INTEGER_X86_KERNELS
+    if (has_bmi2_adx()) {
+        return {add_n_x86, sub_n_x86, mul_1_mulx, addmul_1_adx, submul_1_adx, mul_basecase_adx};
+    }
+#endif
+    return {add_n_generic, sub_n_generic, mul_1_generic, addmul_1_generic, submul_1_generic, mul_basecase_generic};
+}
+
+static limb_kernels const& kernels() {
+    static const limb_kernels k = select_kernels();
+    return k;
+}
+
+// res[0..n] += a[0..m], m <= n, returns carry out of res
+static limb_t add_to(limb_t* res, size_t n, limb_t const* a, size_t m) {
+    limb_t carry = kernels().add_n(res, res, a, m);
+    for (size_t i = m; carry != 0 && i < n; i++) {
+        res[i]++;
+        carry = (res[i] == 0);
+    }
+    return carry;
+}
+
+// res[0..n] -= a[0..m], m <= n, returns borrow out of res
+static limb_t sub_from(limb_t* res, size_t n, limb_t const* a, size_t m) {
+    limb_t borrow = kernels().sub_n(res, res, a, m);
+    for (size_t i = m; borrow != 0 && i < n; i++) {
+        borrow = (res[i] == 0);
+        res[i]--;
+    }
+    return borrow;
+}
+
+static const limb_t ONE = 1;
+
+// res[0..n] = a[0..n] - res[0..n], a >= res
+static void sub_reverse(limb_t* res, limb_t const* a, size_t n) {
+    kernels().sub_n(res, a, res, n);
+}
+
+// res[0..n+1] = op(a, b) for a[0..n] and b[0..m] with signs, m <= n, taken in two's complement.
+// negative values are negated as ~x + 1 on the fly: the carry only passes their low zero limbs,
+// the rest is a plain loop. returns the sign of the result, res may be a or b
+template <typename Op>
+static bool bitwise_limbs(limb_t* res, limb_t const* a, size_t n, bool a_neg,
+                          limb_t const* b, size_t m, bool b_neg, Op op) {
+    limb_t ma = 0 - static_cast<limb_t>(a_neg);
+    limb_t mb = 0 - static_cast<limb_t>(b_neg);
+    limb_t mr = op(ma, mb);
+    limb_t ca = a_neg;
+    limb_t cb = b_neg;
+    size_t i = 0;
+    for (; i < m && (ca | cb) != 0; i++) {
+        limb_t x = (a[i] ^ ma) + ca;
+        limb_t y = (b[i] ^ mb) + cb;
+        ca &= (x == 0);
+        cb &= (y == 0);
+        res[i] = op(x, y) ^ mr;
+    }
+    for (; i < m; i++) {
+        res[i] = op(a[i] ^ ma, b[i] ^ mb) ^ mr;
+    }
+    for (; i < n && ca != 0; i++) {
+        limb_t x = (a[i] ^ ma) + ca;
+        ca &= (x == 0);
+        res[i] = op(x, mb) ^ mr;
+    }
+    for (; i < n; i++) {
+        res[i] = op(a[i] ^ ma, mb) ^ mr;
+    }
+    res[n] = 0;
+    if (mr != 0) {
+        add_to(res, n + 1, &ONE, 1);
+    }
+    return mr != 0;
+}
+
+// res[0..n+m] = a[0..n] * b[0..m], n >= m, res doesn't overlap a and b
+static void mul_basecase(limb_t* res, limb_t const* a, size_t n, limb_t const* b, size_t m) {
+    if (m == 0) {
+        std::fill(res, res + n, 0);
+        return;
+    }
+    kernels().mul_basecase(res, a, n, b, m);
+}
+
+static void mul_limbs(limb_t* res, limb_t const* a, size_t n, limb_t const* b, size_t m);
+
+// n >= m and m <= (n + 1) / 2: a is cut into pieces of length m, so all products are balanced
+static void mul_unbalanced(limb_t* res, limb_t const* a, size_t n, limb_t const* b, size_t m) {
+    scratch_frame frame;
+    std::fill(res, res + n + m, 0);
+    if (use_threads(m)) {
+        // products of the even pieces don't overlap and go straight to res,
+        // the odd ones are added after all of them are ready
+        size_t count = (n + m - 1) / m;
+        limb_t* t = scratch.take(count / 2 * 2 * m);
+        parallel_for(count, true, [&](size_t j) {
+            size_t len = std::min(m, n - j * m);
+            mul_limbs(j % 2 == 0 ? res + j * m : t + j / 2 * 2 * m, a + j * m, len, b, m);
+        });
+        for (size_t j = 1; j < count; j += 2) {
+            size_t len = std::min(m, n - j * m);
+            add_to(res + j * m, n + m - j * m, t + j / 2 * 2 * m, len + m);
+        }
+        return;
+    }
+    limb_t* t = scratch.take(2 * m);
+    for (size_t i = 0; i < n; i += m) {
+        size_t len = std::min(m, n - i);
+        mul_limbs(t, a + i, len, b, m);
+        add_to(res + i, n + m - i, t, len + m);
+    }
+}
+
+// a = a1 * B^h + a0, b = b1 * B^h + b0,
+// a * b = z2 * B^2h + ((a0 + a1)(b0 + b1) - z2 - z0) * B^h + z0
+static void mul_karatsuba(limb_t* res, limb_t const* a, size_t n, limb_t const* b, size_t m) {
+    size_t h = (n + 1) / 2;
+    scratch_frame frame;
+    limb_t* sa = scratch.take(h + 1);
+    limb_t* sb = scratch.take(h + 1);
+    limb_t* t = scratch.take(2 * h + 2);
+
+    std::copy(a, a + h, sa);
+    sa[h] = add_to(sa, h, a + h, n - h);
+    std::copy(b, b + h, sb);
+    sb[h] = add_to(sb, h, b + h, m - h);
+    mul_limbs(t, sa, h + 1, sb, h + 1);
+
+    mul_limbs(res, a, h, b, h);
+    mul_limbs(res + 2 * h, a + h, n - h, b + h, m - h);
+    sub_from(t, 2 * h + 2, res, 2 * h);
+    sub_from(t, 2 * h + 2, res + 2 * h, n + m - 2 * h);
+    // the middle part fits into the result, higher limbs of t are zero
+    add_to(res + h, n + m - h, t, std::min(2 * h + 2, n + m - h));
+}
+
+// res[0..2n] = a[0..n]^2, every cross product a_i * a_j is computed once and doubled
+static void sqr_basecase(limb_t* res, limb_t const* a, size_t n) {
+    if (n == 0) {
+        return;
+    }
+    limb_kernels const& k = kernels();
+    res[0] = 0;
+    res[2 * n - 1] = 0;
+    if (n > 1) {
+        res[n] = k.mul_1(res + 1, a + 1, n - 1, a[0]);
+    }
+    for (size_t i = 1; i + 1 < n; i++) {
+        res[n + i] = k.addmul_1(res + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+    }
+    limb_t carry = 0;
+    limb_t top = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint128_t sq = static_cast<uint128_t>(a[i]) * a[i];
+        limb_t lo = res[2 * i];
+        limb_t hi = res[2 * i + 1];
+        uint128_t x = static_cast<uint128_t>((lo << 1u) | top) + static_cast<limb_t>(sq) + carry;
+        res[2 * i] = static_cast<limb_t>(x);
+        x = static_cast<uint128_t>((hi << 1u) | (lo >> (LIMB_BITS - 1))) + static_cast<limb_t>(sq >> LIMB_BITS)
+            + (x >> LIMB_BITS);
+        res[2 * i + 1] = static_cast<limb_t>(x);
+        carry = static_cast<limb_t>(x >> LIMB_BITS);
+        top = hi >> (LIMB_BITS - 1);
+    }
+}
+
+static void sqr_limbs(limb_t* res, limb_t const* a, size_t n);
+
+// a^2 = a1^2 * B^2h + ((a0 + a1)^2 - a1^2 - a0^2) * B^h + a0^2
+static void sqr_karatsuba(limb_t* res, limb_t const* a, size_t n) {
+    size_t h = (n + 1) / 2;
+    scratch_frame frame;
+    limb_t* sa = scratch.take(h + 1);
+    limb_t* t = scratch.take(2 * h + 2);
+
+    std::copy(a, a + h, sa);
+    sa[h] = add_to(sa, h, a + h, n - h);
+    sqr_limbs(t, sa, h + 1);
+
+    sqr_limbs(res, a, h);
+    sqr_limbs(res + 2 * h, a + h, n - h);
+    sub_from(t, 2 * h + 2, res, 2 * h);
+    sub_from(t, 2 * h + 2, res + 2 * h, 2 * (n - h));
+    add_to(res + h, 2 * n - h, t, std::min(2 * h + 2, 2 * n - h));
+}
+
+// signed values of the toom algorithms are kept in two's complement of fixed width w,
+// all operations on them are modulo B^w
+
+static bool is_negative(limb_t const* a, size_t w) {
+    return (a[w - 1] >> (LIMB_BITS - 1)) != 0;
+}
+
+static void negate(limb_t* a, size_t w) {
+    limb_t carry = 1;
+    for (size_t i = 0; i < w; i++) {
+        a[i] = ~a[i] + carry;
+        carry &= (a[i] == 0);
+    }
+}
+
+// r[0..w] += c * a[0..n], n <= w
+static void addmul_small(limb_t* r, size_t w, limb_t const* a, size_t n, int64_t c) {
+    limb_t d = static_cast<limb_t>(c < 0 ? -c : c);
+    if (c >= 0) {
+        limb_t hi = kernels().addmul_1(r, a, n, d);
+        if (n < w) {
+            add_to(r + n, w - n, &hi, 1);
+        }
+    } else {
+        limb_t hi = kernels().submul_1(r, a, n, d);
+        if (n < w) {
+            sub_from(r + n, w - n, &hi, 1);
+        }
+    }
+}
+
+// arithmetic shift right by 0 < s < 64 bits
+static void shr_signed(limb_t* a, size_t w, unsigned s) {
+    limb_t fill = (is_negative(a, w) ? ~(LIMB_MAX >> s) : 0);
+    for (size_t i = 0; i + 1 < w; i++) {
+        a[i] = (a[i] >> s) | (a[i + 1] << (LIMB_BITS - s));
+    }
+    a[w - 1] = (a[w - 1] >> s) | fill;
+}
+
+// d^(-1) modulo B for odd d: d is its own inverse modulo 8, every newton step doubles the correct bits
+static limb_t inverse_limb(limb_t d) {
+    limb_t inv = d;
+    for (int i = 0; i < 5; i++) {
+        inv *= 2 - d * inv;
+    }
+    return inv;
+}
+
+// a /= d for odd d, when a is known to be divisible by d
+static void divexact_odd(limb_t* a, size_t w, limb_t d) {
+    limb_t inv = inverse_limb(d);
+    limb_t trans = 0;
+    for (size_t i = 0; i < w; i++) {
+        limb_t x = a[i];
+        limb_t s = x - trans;
+        trans = (x < trans);
+        a[i] = s * inv;
+        trans += static_cast<limb_t>((static_cast<uint128_t>(a[i]) * d) >> LIMB_BITS);
+    }
+}
+
+// r[0..w] = a[0..wa] * b[0..wb], w >= wa + wb
+static void mul_signed(limb_t* r, size_t w, limb_t const* a, size_t wa, limb_t const* b, size_t wb) {
+    scratch_frame frame;
+    bool neg_a = is_negative(a, wa);
+    bool neg_b = is_negative(b, wb);
+    if (neg_a) {
+        limb_t* t = scratch.take(wa);
+        std::copy(a, a + wa, t);
+        negate(t, wa);
+        a = t;
+    }
+    if (neg_b) {
+        limb_t* t = scratch.take(wb);
+        std::copy(b, b + wb, t);
+        negate(t, wb);
+        b = t;
+    }
+    while (wa > 0 && a[wa - 1] == 0) {
+        wa--;
+    }
+    while (wb > 0 && b[wb - 1] == 0) {
+        wb--;
+    }
+    std::fill(r + wa + wb, r + w, 0);
+    if (wa == 0 || wb == 0) {
+        std::fill(r, r + wa + wb, 0);
+        return;
+    }
+    mul_limbs(r, a, wa, b, wb);
+    if (neg_a != neg_b) {
+        negate(r, w);
+    }
+}
+
+// r[0..w] = a[0..wa]^2, w >= 2 * wa
+static void sqr_signed(limb_t* r, size_t w, limb_t const* a, size_t wa) {
+    scratch_frame frame;
+    if (is_negative(a, wa)) {
+        limb_t* t = scratch.take(wa);
+        std::copy(a, a + wa, t);
+        negate(t, wa);
+        a = t;
+    }
+    while (wa > 0 && a[wa - 1] == 0) {
+        wa--;
+    }
+    std::fill(r + 2 * wa, r + w, 0);
+    sqr_limbs(r, a, wa);
+}
+
+// r[0..w] = sum c[i] * a_i, where a_i are the pieces of a[0..n] of length k
+static void eval_pieces(limb_t* r, size_t w, limb_t const* a, size_t n, size_t k, int64_t const* c, size_t parts) {
+    std::fill(r, r + w, 0);
+    for (size_t i = 0; i < parts; i++) {
+        addmul_small(r, w, a + i * k, std::min(k, n - i * k), c[i]);
+    }
+}
+
+// res[0..n+m] = sum c_i * B^(ik), c_i are non-negative values of width w
+static void recompose(limb_t* res, size_t len, limb_t* const* c, size_t parts, size_t w, size_t k) {
+    std::fill(res, res + len, 0);
+    for (size_t i = 0; i < parts; i++) {
+        add_to(res + i * k, len - i * k, c[i], std::min(w, len - i * k));
+    }
+}
+
+// a splits into 3 pieces and b into 2 pieces of length k, r(x) = a(x) * b(x)
+// is restored by the values at 0, 1, -1 and infinity
+static void mul_toom32(limb_t* res, limb_t const* a, size_t n, limb_t const* b, size_t m) {
+    size_t k = std::max((n + 2) / 3, (m + 1) / 2);
+    size_t w = k + 1;
+    size_t L = 2 * w;
+    static const int64_t at_one[] = {1, 1, 1};
+    static const int64_t at_minus_one[] = {1, -1, 1};
+    scratch_frame frame;
+    limb_t* ea = scratch.take(2 * w);
+    limb_t* eb = scratch.take(2 * w);
+    limb_t* r = scratch.take(4 * L);
+    limb_t* r0 = r;
+    limb_t* r1 = r + L;
+    limb_t* rm1 = r + 2 * L;
+    limb_t* rinf = r + 3 * L;
+
+    eval_pieces(ea, w, a, n, k, at_one, 3);
+    eval_pieces(ea + w, w, a, n, k, at_minus_one, 3);
+    eval_pieces(eb, w, b, m, k, at_one, 2);
+    eval_pieces(eb + w, w, b, m, k, at_minus_one, 2);
+
+    parallel_for(4, use_threads(m), [&](size_t i) {
+        if (i == 0) {
+            std::fill(r0 + 2 * k, r0 + L, 0);
+            mul_limbs(r0, a, k, b, k);
+        } else if (i == 3) {
+            std::fill(rinf, rinf + L, 0);
+            mul_limbs(rinf, a + 2 * k, n - 2 * k, b + k, m - k);
+        } else {
+            mul_signed(r + i * L, L, ea + (i - 1) * w, w, eb + (i - 1) * w, w);
+        }
+    });
+
+    // r1 = c1 + c3, rm1 = c0 + c2
+    sub_from(r1, L, rm1, L);
+    shr_signed(r1, L, 1);
+    add_to(rm1, L, r1, L);
+    sub_from(rm1, L, r0, L);
+    sub_from(r1, L, rinf, L);
+
+    limb_t* c[] = {r0, r1, rm1, rinf};
+    recompose(res, n + m, c, 4, L, k);
+}
+
+static const int64_t TOOM3_POINTS[][3] = {{1, 1, 1}, {1, -1, 1}, {1, 2, 4}};
+
+// r holds the values of r(x) = c0 + c1 x + ... + c4 x^4 at 0, 1, -1, 2 and infinity
+static void toom3_interpolate(limb_t* res, size_t len, limb_t* r, size_t L, size_t k) {
+    limb_t* r0 = r;
+    limb_t* r1 = r + L;
+    limb_t* rm1 = r + 2 * L;
+    limb_t* r2 = r + 3 * L;
+    limb_t* rinf = r + 4 * L;
+
+    // odd part: r1 = c1 + c3, even part: rm1 = c0 + c2 + c4
+    sub_from(r1, L, rm1, L);
+    shr_signed(r1, L, 1);
+    add_to(rm1, L, r1, L);
+    sub_from(rm1, L, r0, L);
+    sub_from(rm1, L, rinf, L);
+    // r2 = c0 + 2c1 + 4c2 + 8c3 + 16c4 turns into c1 + 4c3
+    sub_from(r2, L, r0, L);
+    addmul_small(r2, L, rm1, L, -4);
+    addmul_small(r2, L, rinf, L, -16);
+    shr_signed(r2, L, 1);
+    sub_from(r2, L, r1, L);
+    divexact_odd(r2, L, 3);
+    sub_from(r1, L, r2, L);
+
+    limb_t* c[] = {r0, r1, rm1, r2, rinf};
+    recompose(res, len, c, 5, L, k);
+}
+
+// both operands split into 3 pieces of length k, r(x) = a(x) * b(x)
+// is restored by the values at 0, 1, -1, 2 and infinity
+static void mul_toom33(limb_t* res, limb_t const* a, size_t n, limb_t const* b, size_t m) {
+    size_t k = (n + 2) / 3;
+    size_t w = k + 1;
+    size_t L = 2 * w;
+    scratch_frame frame;
+    limb_t* ea = scratch.take(3 * w);
+    limb_t* eb = scratch.take(3 * w);
+    limb_t* r = scratch.take(5 * L);
+
+    parallel_for(5, use_threads(m), [&](size_t i) {
+        if (i == 0) {
+            std::fill(r + 2 * k, r + L, 0);
+            mul_limbs(r, a, k, b, k);
+        } else if (i == 4) {
+            std::fill(r + 4 * L, r + 5 * L, 0);
+            mul_limbs(r + 4 * L, a + 2 * k, n - 2 * k, b + 2 * k, m - 2 * k);
+        } else {
+            limb_t* x = ea + (i - 1) * w;
+            limb_t* y = eb + (i - 1) * w;
+            eval_pieces(x, w, a, n, k, TOOM3_POINTS[i - 1], 3);
+            eval_pieces(y, w, b, m, k, TOOM3_POINTS[i - 1], 3);
+            mul_signed(r + i * L, L, x, w, y, w);
+        }
+    });
+    toom3_interpolate(res, n + m, r, L, k);
+}
+
+static void sqr_toom3(limb_t* res, limb_t const* a, size_t n) {
+    size_t k = (n + 2) / 3;
+    size_t w = k + 1;
+    size_t L = 2 * w;
+    scratch_frame frame;
+    limb_t* ea = scratch.take(3 * w);
+    limb_t* r = scratch.take(5 * L);
+
+    parallel_for(5, use_threads(n), [&](size_t i) {
+        if (i == 0) {
+            std::fill(r + 2 * k, r + L, 0);
+            sqr_limbs(r, a, k);
+        } else if (i == 4) {
+            std::fill(r + 4 * L, r + 5 * L, 0);
+            sqr_limbs(r + 4 * L, a + 2 * k, n - 2 * k);
+        } else {
+            limb_t* x = ea + (i - 1) * w;
+            eval_pieces(x, w, a, n, k, TOOM3_POINTS[i - 1], 3);
+            sqr_signed(r + i * L, L, x, w);
+        }
+    });
+    toom3_interpolate(res, 2 * n, r, L, k);
+}
+
+static const int64_t TOOM4_POINTS[][4] = {{1, 1, 1, 1}, {1, -1, 1, -1}, {1, 2, 4, 8}, {1, -2, 4, -8}, {8, 4, 2, 1}};
+
+// r holds the values of r(x) = c0 + c1 x + ... + c6 x^6 at 0, 1, -1, 2, -2, infinity
+// and 64 r(1/2) before infinity
+static void toom4_interpolate(limb_t* res, size_t len, limb_t* r, size_t L, size_t k) {
+    limb_t* r0 = r;
+    limb_t* r1 = r + L;
+    limb_t* rm1 = r + 2 * L;
+    limb_t* r2 = r + 3 * L;
+    limb_t* rm2 = r + 4 * L;
+    limb_t* rh = r + 5 * L;
+    limb_t* rinf = r + 6 * L;
+
+    // r1 = c1 + c3 + c5, rm1 = c0 + c2 + c4 + c6
+    sub_from(r1, L, rm1, L);
+    shr_signed(r1, L, 1);
+    add_to(rm1, L, r1, L);
+    // r2 = c1 + 4c3 + 16c5, rm2 = c0 + 4c2 + 16c4 + 64c6
+    sub_from(r2, L, rm2, L);
+    shr_signed(r2, L, 2);
+    addmul_small(rm2, L, r2, L, 2);
+
+    // even coefficients: rm1 = c2 + c4, rm2 = c2 + 4c4
+    sub_from(rm1, L, r0, L);
+    sub_from(rm1, L, rinf, L);
+    sub_from(rm2, L, r0, L);
+    addmul_small(rm2, L, rinf, L, -64);
+    shr_signed(rm2, L, 2);
+    sub_from(rm2, L, rm1, L);
+    divexact_odd(rm2, L, 3);
+    sub_from(rm1, L, rm2, L);
+
+    // rh = 64c0 + 32c1 + 16c2 + 8c3 + 4c4 + 2c5 + c6 turns into 16c1 + 4c3 + c5
+    addmul_small(rh, L, r0, L, -64);
+    addmul_small(rh, L, rm1, L, -16);
+    addmul_small(rh, L, rm2, L, -4);
+    sub_from(rh, L, rinf, L);
+    shr_signed(rh, L, 1);
+    // r2 = c3 + 5c5, rh = -(4c3 + 5c5)
+    sub_from(r2, L, r1, L);
+    divexact_odd(r2, L, 3);
+    addmul_small(rh, L, r1, L, -16);
+    divexact_odd(rh, L, 3);
+    // rh = c3, r2 = c5, r1 = c1
+    add_to(rh, L, r2, L);
+    divexact_odd(rh, L, 3);
+    negate(rh, L);
+    sub_from(r2, L, rh, L);
+    divexact_odd(r2, L, 5);
+    sub_from(r1, L, rh, L);
+    sub_from(r1, L, r2, L);
+
+    limb_t* c[] = {r0, r1, rm1, rh, rm2, r2, rinf};
+    recompose(res, len, c, 7, L, k);
+}
+
+// both operands split into 4 pieces of length k, r(x) = a(x) * b(x)
+// is restored by the values at 0, 1, -1, 2, -2, 1/2 and infinity
+static void mul_toom44(limb_t* res, limb_t const* a, size_t n, limb_t const* b, size_t m) {
+    size_t k = (n + 3) / 4;
+    size_t w = k + 1;
+    size_t L = 2 * w;
+    scratch_frame frame;
+    limb_t* ea = scratch.take(5 * w);
+    limb_t* eb = scratch.take(5 * w);
+    limb_t* r = scratch.take(7 * L);
+
+    parallel_for(7, use_threads(m), [&](size_t i) {
+        if (i == 0) {
+            std::fill(r + 2 * k, r + L, 0);
+            mul_limbs(r, a, k, b, k);
+        } else if (i == 6) {
+            std::fill(r + 6 * L, r + 7 * L, 0);
+            mul_limbs(r + 6 * L, a + 3 * k, n - 3 * k, b + 3 * k, m - 3 * k);
+        } else {
+            limb_t* x = ea + (i - 1) * w;
+            limb_t* y = eb + (i - 1) * w;
+            eval_pieces(x, w, a, n, k, TOOM4_POINTS[i - 1], 4);
+            eval_pieces(y, w, b, m, k, TOOM4_POINTS[i - 1], 4);
+            mul_signed(r + i * L, L, x, w, y, w);
+        }
+    });
+    toom4_interpolate(res, n + m, r, L, k);
+}
+
+static void sqr_toom4(limb_t* res, limb_t const* a, size_t n) {
+    size_t k = (n + 3) / 4;
+    size_t w = k + 1;
+    size_t L = 2 * w;
+    scratch_frame frame;
+    limb_t* ea = scratch.take(5 * w);
+    limb_t* r = scratch.take(7 * L);
+
+    parallel_for(7, use_threads(n), [&](size_t i) {
+        if (i == 0) {
+            std::fill(r + 2 * k, r + L, 0);
+            sqr_limbs(r, a, k);
+        } else if (i == 6) {
+            std::fill(r + 6 * L, r + 7 * L, 0);
+            sqr_limbs(r + 6 * L, a + 3 * k, n - 3 * k);
+        } else {
+            limb_t* x = ea + (i - 1) * w;
+            eval_pieces(x, w, a, n, k, TOOM4_POINTS[i - 1], 4);
+            sqr_signed(r + i * L, L, x, w);
+        }
+    });
+    toom4_interpolate(res, 2 * n, r, L, k);
+}
+
+static uint32_t half_limb(limb_t const* a, size_t i) {
+    return static_cast<uint32_t>(a[i / 2] >> (32u * (i % 2)));
+}
+
+// with threads, transforms and loops over the points are cut into tasks of this many points
+static const size_t NTT_TASK_POINTS = (1u << 15u);
+
+// number theoretic transform modulo three primes p = c * 2^k + 1 < 2^31, limbs are taken
+// by halves and the convolution of the halves is restored from the residues by chinese
+// remainder theorem. values are multiplied in montgomery form with R = 2^32
+class ntt_prime {
+public:
+    ntt_prime(uint32_t p, uint32_t g) : p(p), g(g), pinv(1), r2(0) {
+        // -p^(-1) modulo 2^32 by newton iteration
+        for (int i = 0; i < 5; i++) {
+            pinv *= 2 - p * pinv;
+        }
+        pinv = -pinv;
+        r2 = static_cast<uint32_t>(-static_cast<uint64_t>(p) % p);
+    }
+
+    // values are below p < 2^31, so the top bit tells that p must be added back
+    uint32_t add(uint32_t a, uint32_t b) const {
+        uint32_t s = a + b - p;
+        return s + (p & -(s >> 31u));
+    }
+
+    uint32_t sub(uint32_t a, uint32_t b) const {
+        uint32_t s = a - b;
+        return s + (p & -(s >> 31u));
+    }
+
+    // a * b / R
+    uint32_t mul(uint32_t a, uint32_t b) const {
+        uint64_t t = static_cast<uint64_t>(a) * b;
+        uint32_t m = static_cast<uint32_t>(t) * pinv;
+        uint32_t u = static_cast<uint32_t>((t + static_cast<uint64_t>(m) * p) >> 32u) - p;
+        return u + (p & -(u >> 31u));
+    }
+
+    uint32_t pow(uint64_t a, uint64_t e) const {
+        uint64_t res = 1;
+        a %= p;
+        for (; e > 0; e >>= 1u) {
+            if (e & 1u) {
+                res = res * a % p;
+            }
+            a = a * a % p;
+        }
+        return static_cast<uint32_t>(res);
+    }
+
+    // w[len + j] = (root of unity of degree 2len)^j in montgomery form, for all len < n.
+    // tables are shared by all threads, a grown table is a new one and the old ones
+    // stay alive, so the pointers given before remain valid
+    uint32_t const* roots(size_t n, bool inverse) const {
+        std::lock_guard<std::mutex> lock(roots_mutex);
+        std::vector<std::vector<uint32_t>>& tables = (inverse ? iroots : froots);
+        if (tables.empty() || tables.back().size() < n) {
+            std::vector<uint32_t> w(n);
+            size_t len = 1;
+            if (!tables.empty()) {
+                std::copy(tables.back().begin(), tables.back().end(), w.begin());
+                len = tables.back().size();
+            }
+            for (; len < n; len *= 2) {
+                uint32_t step = pow(g, (p - 1) / (2 * len));
+                if (inverse) {
+                    step = pow(step, p - 2);
+                }
+                step = mul(step, r2);
+                uint32_t cur = mul(1, r2);
+                for (size_t j = 0; j < len; j++) {
+                    w[len + j] = cur;
+                    cur = mul(cur, step);
+                }
+            }
+            tables.push_back(std::move(w));
+        }
+        return tables.back().data();
+    }
+
+    // decimation in frequency, the result is in bit reversed order
+    void forward(uint32_t* a, size_t n, uint32_t const* w, bool parallel) const {
+        if (parallel && n > NTT_TASK_POINTS) {
+            // after the first level the halves are independent transforms
+            size_t len = n / 2;
+            parallel_ranges(len, NTT_TASK_POINTS, true, [&](size_t begin, size_t end) {
+                for (size_t j = begin; j < end; j++) {
+                    uint32_t u = a[j];
+                    uint32_t v = a[j + len];
+                    a[j] = add(u, v);
+                    a[j + len] = mul(sub(u, v), w[len + j]);
+                }
+            });
+            parallel_for(2, true, [&](size_t i) {
+                forward(a + i * len, len, w, true);
+            });
+            return;
+        }
+        for (size_t len = n / 2; len >= 1; len /= 2) {
+            for (size_t i = 0; i < n; i += 2 * len) {
+                for (size_t j = 0; j < len; j++) {
+                    uint32_t u = a[i + j];
+                    uint32_t v = a[i + j + len];
+                    a[i + j] = add(u, v);
+                    a[i + j + len] = mul(sub(u, v), w[len + j]);
+                }
+            }
+        }
+    }
+
+    // decimation in time from bit reversed order, the result is multiplied by n
+    void inverse(uint32_t* a, size_t n, uint32_t const* w, bool parallel) const {
+        if (parallel && n > NTT_TASK_POINTS) {
+            // the halves are independent transforms up to the last level
+            size_t len = n / 2;
+            parallel_for(2, true, [&](size_t i) {
+                inverse(a + i * len, len, w, true);
+            });
+            parallel_ranges(len, NTT_TASK_POINTS, true, [&](size_t begin, size_t end) {
+                for (size_t j = begin; j < end; j++) {
+                    uint32_t u = a[j];
+                    uint32_t v = mul(a[j + len], w[len + j]);
+                    a[j] = add(u, v);
+                    a[j + len] = sub(u, v);
+                }
+            });
+            return;
+        }
+        for (size_t len = 1; len < n; len *= 2) {
+            for (size_t i = 0; i < n; i += 2 * len) {
+                for (size_t j = 0; j < len; j++) {
+                    uint32_t u = a[i + j];
+                    uint32_t v = mul(a[i + j + len], w[len + j]);
+                    a[i + j] = add(u, v);
+                    a[i + j + len] = sub(u, v);
+                }
+            }
+        }
+    }
+
+    // res[0..N] = residues of the convolution of the halves a[0..n] * b[0..m] modulo p,
+    // N is a power of two
+    void convolution(uint32_t* res, size_t N, limb_t const* a, size_t n, limb_t const* b, size_t m,
+                     bool parallel) const {
+        uint32_t const* fw = roots(N, false);
+        uint32_t const* iw = roots(N, true);
+        // a square needs only one forward transform
+        bool square = (a == b && n == m);
+        std::vector<uint32_t> fb(square ? 0 : N);
+        uint32_t* tb = (square ? res : fb.data());
+        parallel_for(square ? 1 : 2, parallel, [&](size_t k) {
+            uint32_t* t = (k == 0 ? res : tb);
+            limb_t const* x = (k == 0 ? a : b);
+            size_t len = (k == 0 ? n : m);
+            parallel_ranges(N, NTT_TASK_POINTS, parallel, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    t[i] = (i < len ? half_limb(x, i) % p : 0);
+                }
+            });
+            forward(t, N, fw, parallel);
+        });
+        // (a * b / R) * (R^2 / n) / R, the inverse transform is linear and multiplies it by n back
+        uint32_t scale = static_cast<uint32_t>(static_cast<uint64_t>(r2) * pow(N, p - 2) % p);
+        parallel_ranges(N, NTT_TASK_POINTS, parallel, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                res[i] = mul(mul(res[i], tb[i]), scale);
+            }
+        });
+        inverse(res, N, iw, parallel);
+    }
+
+    uint32_t const p;
+
+private:
+    uint32_t g;
+    uint32_t pinv;
+    uint32_t r2;
+    mutable std::mutex roots_mutex;
+    mutable std::vector<std::vector<uint32_t>> froots;
+    mutable std::vector<std::vector<uint32_t>> iroots;
+};
+
+// 2^27, 2^26 and 2^25 divide p - 1, the longest transform has 2^25 points
+static const size_t NTT_MAX_LEN = (1u << 25u);
+
+static ntt_prime const& ntt_field(size_t i) {
+    static ntt_prime const fields[] = {{2013265921, 31}, {1811939329, 13}, {2113929217, 5}};
+    return fields[i];
+}
+
+// res[0..n+m] = a[0..n] * b[0..m], 2(n + m) <= NTT_MAX_LEN
+static void mul_ntt(limb_t* res, limb_t const* a, size_t n, limb_t const* b, size_t m) {
+    size_t len = 2 * (n + m);
+    size_t N = 1;
+    while (N < len) {
+        N *= 2;
+    }
+    bool parallel = use_threads(m);
+    std::vector<uint32_t> residues(3 * N);
+    uint32_t* r[3];
+    parallel_for(3, parallel, [&](size_t i) {
+        r[i] = residues.data() + i * N;
+        ntt_field(i).convolution(r[i], N, a, 2 * n, b, 2 * m, parallel);
+    });
+
+    // garner: c = r0 + p0 * (v1 + p1 * v2), coefficients are below N * 2^64 < p0 * p1 * p2.
+    // every piece carries from zero, the carries out of the pieces are added at the end
+    ntt_prime const& f0 = ntt_field(0);
+    ntt_prime const& f1 = ntt_field(1);
+    ntt_prime const& f2 = ntt_field(2);
+    uint64_t p0 = f0.p;
+    uint64_t p1 = f1.p;
+    uint64_t inv01 = f1.pow(p0, f1.p - 2);
+    uint64_t inv012 = f2.pow(p0 * p1 % f2.p, f2.p - 2);
+    size_t piece = (parallel ? NTT_TASK_POINTS : len);
+    std::vector<limb_t> carries((len + piece - 1) / piece);
+    parallel_ranges(len, piece, parallel, [&](size_t begin, size_t end) {
+        uint64_t trans = 0;
+        for (size_t i = begin; i < end; i++) {
+            uint64_t x0 = r[0][i];
+            uint64_t v1 = (r[1][i] + p1 - x0 % p1) * inv01 % p1;
+            uint64_t x01 = (x0 + p0 * v1) % f2.p;
+            uint64_t v2 = (r[2][i] + f2.p - x01) * inv012 % f2.p;
+            uint64_t t = v1 + p1 * v2;
+            uint64_t lo = (t & UINT32_MAX) * p0 + x0 + (trans & UINT32_MAX);
+            trans = (t >> 32u) * p0 + (trans >> 32u) + (lo >> 32u);
+            if (i % 2 == 0) {
+                res[i / 2] = static_cast<uint32_t>(lo);
+            } else {
+                res[i / 2] |= static_cast<limb_t>(static_cast<uint32_t>(lo)) << 32u;
+            }
+        }
+        carries[begin / piece] = trans;
+    });
+    for (size_t i = 1; i < carries.size(); i++) {
+        size_t pos = i * piece / 2;
+        add_to(res + pos, n + m - pos, &carries[i - 1], 1);
+    }
+}
+
+// res[0..2n] = a[0..n]^2, res doesn't overlap a
+static void sqr_limbs(limb_t* res, limb_t const* a, size_t n) {
+    if (n < SQR_KARATSUBA_THRESHOLD) {
+        STATS_TIER(SQR_BASECASE);
+        sqr_basecase(res, a, n);
+    } else if (n >= NTT_THRESHOLD && 4 * n <= NTT_MAX_LEN) {
+        STATS_TIER(SQR_NTT);
+        mul_ntt(res, a, n, a, n);
+    } else if (n < TOOM3_THRESHOLD) {
+        STATS_TIER(SQR_KARATSUBA);
+        sqr_karatsuba(res, a, n);
+    } else if (n < TOOM4_THRESHOLD) {
+        STATS_TIER(SQR_TOOM3);
+        sqr_toom3(res, a, n);
+    } else {
+        STATS_TIER(SQR_TOOM4);
+        sqr_toom4(res, a, n);
+    }
+}
+
+// res[0..n+m] = a[0..n] * b[0..m], res doesn't overlap a and b
+static void mul_limbs(limb_t* res, limb_t const* a, size_t n, limb_t const* b, size_t m) {
+    if (a == b && n == m) {
+        sqr_limbs(res, a, n);
+        return;
+    }
+    if (n < m) {
+        std::swap(a, b);
+        std::swap(n, m);
+    }
+    if (m < KARATSUBA_THRESHOLD) {
+        STATS_TIER(MUL_BASECASE);
+        mul_basecase(res, a, n, b, m);
+    } else if (m >= NTT_THRESHOLD && 2 * (n + m) <= NTT_MAX_LEN) {
+        STATS_TIER(MUL_NTT);
+        mul_ntt(res, a, n, b, m);
+    } else if (m <= (n + 1) / 2) {
+        STATS_TIER(MUL_UNBALANCED);
+        mul_unbalanced(res, a, n, b, m);
+    } else if (m < TOOM3_THRESHOLD) {
+        STATS_TIER(MUL_KARATSUBA);
+        mul_karatsuba(res, a, n, b, m);
+    } else if (m >= TOOM4_THRESHOLD && m > 3 * ((n + 3) / 4)) {
+        STATS_TIER(MUL_TOOM44);
+        mul_toom44(res, a, n, b, m);
+    } else if (m > 2 * ((n + 2) / 3)) {
+        STATS_TIER(MUL_TOOM33);
+        mul_toom33(res, a, n, b, m);
+    } else {
+        STATS_TIER(MUL_TOOM32);
+        mul_toom32(res, a, n, b, m);
+    }
+}
+
+static unsigned leading_zeros(limb_t x) {
+    unsigned res = 0;
+    for (; (x >> (LIMB_BITS - 1)) == 0; x <<= 1u) {
+        res++;
+    }
+    return res;
+}
+
+// res[0..n] = a[0..n] << s for s < 64, returns the bits shifted out. each limb is a funnel
+// shift of two neighbours, from the top, so res may be a or lie above it
+static limb_t shl_limbs(limb_t* res, limb_t const* a, size_t n, unsigned s) {
+    if (n == 0) {
+        return 0;
+    }
+    limb_t out = static_cast<limb_t>((static_cast<uint128_t>(a[n - 1]) << s) >> LIMB_BITS);
+    for (size_t i = n - 1; i > 0; i--) {
+        uint128_t x = (static_cast<uint128_t>(a[i]) << LIMB_BITS) | a[i - 1];
+        res[i] = static_cast<limb_t>((x << s) >> LIMB_BITS);
+    }
+    res[0] = a[0] << s;
+    return out;
+}
+
+// res[0..n] = a[0..n] >> s for s < 64, from the bottom, so res may be a or lie below it
+static void shr_limbs(limb_t* res, limb_t const* a, size_t n, unsigned s) {
+    if (n == 0) {
+        return;
+    }
+    for (size_t i = 0; i + 1 < n; i++) {
+        uint128_t x = (static_cast<uint128_t>(a[i + 1]) << LIMB_BITS) | a[i];
+        res[i] = static_cast<limb_t>(x >> s);
+    }
+    res[n - 1] = a[n - 1] >> s;
+}
+
+static int compare_limbs(limb_t const* a, limb_t const* b, size_t n) {
+    for (size_t i = n; i > 0; i--) {
+        if (a[i - 1] != b[i - 1]) {
+            return (a[i - 1] < b[i - 1] ? -1 : 1);
+        }
+    }
+    return 0;
+}
+
+static bool is_zero_limbs(limb_t const* a, size_t n) {
+    return std::all_of(a, a + n, [](limb_t x) { return x == 0; });
+}
+
+// all divisions below take a[0..n+m] and normalized b[0..n] (the top bit is set),
+// write q[0..m+1] = a / b and leave the remainder in a[0..n] with zeros above it
+
+// two limbs divided by a normalized one through its reciprocal v = (B^2 - 1) / d - B,
+// as in "Improved division by invariant integers" by Moller and Granlund
+class limb_divisor {
+public:
+    explicit limb_divisor(limb_t d) : d(d), v(static_cast<limb_t>(~static_cast<uint128_t>(0) / d)) {
+    }
+
+    // (u1 * B + u0) / d for u1 < d, r is the remainder
+    limb_t divide(limb_t u1, limb_t u0, limb_t& r) const {
+        uint128_t q = static_cast<uint128_t>(v) * u1 + ((static_cast<uint128_t>(u1) << LIMB_BITS) | u0);
+        limb_t q1 = static_cast<limb_t>(q >> LIMB_BITS) + 1;
+        limb_t q0 = static_cast<limb_t>(q);
+        r = u0 - q1 * d;
+        if (r > q0) {
+            q1--;
+            r += d;
+        }
+        if (r >= d) {
+            q1++;
+            r -= d;
+        }
+        return q1;
+    }
+
+private:
+    limb_t d;
+    limb_t v;
+};
+
+// knuth's algorithm D, n >= 2
+static void divrem_schoolbook(limb_t* q, limb_t* a, size_t m, limb_t const* b, size_t n) {
+    q[m] = 0;
+    if (compare_limbs(a + m, b, n) >= 0) {
+        sub_from(a + m, n, b, n);
+        q[m] = 1;
+    }
+    limb_t top = b[n - 1];
+    limb_divisor divisor(top);
+    submul_1_fn submul_1 = kernels().submul_1;
+    for (size_t j = m; j-- > 0;) {
+        // estimate by two limbs, after the correction by the third one qhat is at most 1 too big.
+        // the top limb of a is at most top, if it's equal qhat is B - 1
+        limb_t qhat;
+        limb_t rhat;
+        bool rhat_big = false;
+        if (a[j + n] < top) {
+            qhat = divisor.divide(a[j + n], a[j + n - 1], rhat);
+        } else {
+            qhat = LIMB_MAX;
+            rhat = a[j + n - 1] + top;
+            rhat_big = (rhat < top);
+        }
+        while (!rhat_big
+               && static_cast<uint128_t>(qhat) * b[n - 2] > ((static_cast<uint128_t>(rhat) << LIMB_BITS) | a[j + n - 2])) {
+            qhat--;
+            rhat += top;
+            rhat_big = (rhat < top);
+        }
+
+        // a[j..j+n+1] -= qhat * b
+        limb_t borrow = submul_1(a + j, b, n, qhat);
+        limb_t x = a[j + n];
+        a[j + n] = x - borrow;
+        if (x < borrow) {
+            qhat--;
+            a[j + n] += add_to(a + j, n, b, n);
+        }
+        q[j] = qhat;
+    }
+}
+
+static void divrem_normalized(limb_t* q, limb_t* a, size_t m, limb_t const* b, size_t n,
+                              limb_t const* x = nullptr);
+
+// burnikel-ziegler recursion (as RecursiveDivRem in "Modern Computer Arithmetic"), m <= n:
+// the high half of the quotient is found from the top limbs of b, then fixed by the rest of b
+static void divrem_recursive(limb_t* q, limb_t* a, size_t m, limb_t const* b, size_t n) {
+    if (m < BZ_THRESHOLD) {
+        divrem_schoolbook(q, a, m, b, n);
+        return;
+    }
+    size_t k = m / 2;
+    size_t len = n + m;
+    scratch_frame frame;
+    limb_t* t = scratch.take(m + 1);
+    limb_t* q0 = scratch.take(k + 1);
+
+    // q1 = a[2k..] / b[k..], then a -= q1 * b[0..k] * B^k
+    std::fill(q + k + 1, q + m + 1, 0);
+    divrem_recursive(q + k, a + 2 * k, m - k, b + k, n - k);
+    mul_limbs(t, q + k, m - k + 1, b, k);
+    limb_t neg = sub_from(a + k, len - k, t, m + 1);
+    while (neg != 0) {
+        sub_from(q + k, m - k + 1, &ONE, 1);
+        neg -= add_to(a + k, len - k, b, n);
+    }
+
+    // q0 = a[k..n+k] / b[k..], then a -= q0 * b[0..k]
+    divrem_recursive(q0, a + k, k, b + k, n - k);
+    mul_limbs(t, q0, k + 1, b, k);
+    neg = sub_from(a, len, t, 2 * k + 1);
+    while (neg != 0) {
+        sub_from(q0, k + 1, &ONE, 1);
+        neg -= add_to(a, len, b, n);
+    }
+    std::fill(q, q + k, 0);
+    add_to(q, m + 1, q0, k + 1);
+}
+
+// x[0..n+1] = (B^2n - 1) / b up to a few units by newton iteration: the reciprocal of the top
+// half of b gives half of the limbs, one step x += x * (B^2n - b * x) / B^2n doubles them.
+// two extra limbs of the half keep its error from growing through the levels
+static void reciprocal(limb_t* x, limb_t const* b, size_t n) {
+    scratch_frame frame;
+    if (n < NEWTON_THRESHOLD) {
+        limb_t* u = scratch.take(2 * n);
+        std::fill(u, u + 2 * n, LIMB_MAX);
+        divrem_normalized(x, u, n, b, n);
+        return;
+    }
+    size_t h = n / 2 + 2;
+    size_t l = n - h;
+    limb_t* xh = scratch.take(h + 1);
+    reciprocal(xh, b + l, h);
+
+    // e = B^(n+h) - b * xh, |e| is about B^n
+    size_t elen = n + h + 1;
+    limb_t* e = scratch.take(elen);
+    mul_limbs(e, b, n, xh, h + 1);
+    negate(e, elen);
+    e[n + h]++;
+    bool neg = is_negative(e, elen);
+    if (neg) {
+        negate(e, elen);
+    }
+    while (elen > 0 && e[elen - 1] == 0) {
+        elen--;
+    }
+    limb_t* c = scratch.take(h + 1 + elen);
+    mul_limbs(c, xh, h + 1, e, elen);
+
+    std::fill(x, x + l, 0);
+    std::copy(xh, xh + h + 1, x + l);
+    if (h + 1 + elen > 2 * h) {
+        size_t clen = std::min(h + 1 + elen - 2 * h, n + 1);
+        if (neg) {
+            sub_from(x, n + 1, c + 2 * h, clen);
+        } else {
+            add_to(x, n + 1, c + 2 * h, clen);
+        }
+    }
+}
+
+// m <= n, x is about (B^2n - 1) / b: the quotient is taken from the top limbs of a
+// multiplied by x, it differs from the real one by a few units
+static void divrem_barrett(limb_t* q, limb_t* a, size_t m, limb_t const* b, limb_t const* x, size_t n) {
+    scratch_frame frame;
+    limb_t* t = scratch.take(n + m + 1);
+    mul_limbs(t, a + n, m, x, n + 1);
+    std::copy(t + n, t + n + m + 1, q);
+    mul_limbs(t, q, m + 1, b, n);
+    limb_t neg = sub_from(a, n + m, t, n + m);
+    neg += (t[n + m] != 0);
+    while (neg != 0) {
+        sub_from(q, m + 1, &ONE, 1);
+        neg -= add_to(a, n + m, b, n);
+    }
+    while (!is_zero_limbs(a + n, m) || compare_limbs(a, b, n) >= 0) {
+        add_to(q, m + 1, &ONE, 1);
+        sub_from(a, n + m, b, n);
+    }
+}
+
+// m < n: the quotient is that of the top 2m limbs of a by the top m limbs of b, less a few
+// units that the low limbs of b take off. so a short quotient costs a division of its own length
+// and an unbalanced product, not a reciprocal or schoolbook steps over all of b
+static void divrem_short(limb_t* q, limb_t* a, size_t m, limb_t const* b, size_t n) {
+    size_t k = n - m;
+    scratch_frame frame;
+    limb_t* t = scratch.take(n + 1);
+    divrem_normalized(q, a + k, m, b + k, m);
+    mul_limbs(t, q, m + 1, b, k);
+    limb_t neg = sub_from(a, n + m, t, n + 1);
+    while (neg != 0) {
+        sub_from(q, m + 1, &ONE, 1);
+        neg -= add_to(a, n + m, b, n);
+    }
+}
+
+// x is the reciprocal of b if it's known already
+static void divrem_normalized(limb_t* q, limb_t* a, size_t m, limb_t const* b, size_t n,
+                              limb_t const* x) {
+    scratch_frame frame;
+    // a reciprocal of all of b pays off only for a quotient of at least as many limbs
+    if (x == nullptr && n >= NEWTON_THRESHOLD && m >= n) {
+        limb_t* y = scratch.take(n + 1);
+        reciprocal(y, b, n);
+        x = y;
+    }
+    // long quotients are found by blocks of n limbs from the top, as digits of the schoolbook division
+    limb_t* t = scratch.take(std::min(m, n) + 1);
+    size_t qlen = m + 1;
+    std::fill(q, q + qlen, 0);
+    while (m > 0) {
+        size_t step = std::min(m, n);
+        m -= step;
+        if (x != nullptr) {
+            STATS_TIER(DIV_BARRETT);
+            divrem_barrett(t, a + m, step, b, x, n);
+        } else if (step < BZ_THRESHOLD) {
+            STATS_TIER(DIV_SCHOOLBOOK);
+            divrem_schoolbook(t, a + m, step, b, n);
+        } else if (step < n) {
+            divrem_short(t, a + m, step, b, n);
+        } else {
+            STATS_TIER(DIV_RECURSIVE);
+            divrem_recursive(t, a + m, step, b, n);
+        }
+        add_to(q + m, qlen - m, t, step + 1);
+    }
+}
+
+// q[0..n-m+2] = a / d, r[0..m] = a % d (if r isn't null), n >= m >= 2, d[m-1] != 0.
+// a and d are normalized into scratch, so they may alias q and r. x is the reciprocal
+// of normalized d and v normalized d itself, if they're known
+static void divrem_limbs(limb_t* q, limb_t* r, limb_t const* a, size_t n, limb_t const* d, size_t m,
+                         limb_t const* x = nullptr, limb_t const* v = nullptr) {
+    scratch_frame frame;
+    limb_t* u = scratch.take(n + 1);
+    unsigned s = leading_zeros(d[m - 1]);
+    if (v == nullptr) {
+        limb_t* w = scratch.take(m);
+        shl_limbs(w, d, m, s);
+        v = w;
+    }
+    u[n] = shl_limbs(u, a, n, s);
+    divrem_normalized(q, u, n + 1 - m, v, m, x);
+    if (r != nullptr) {
+        shr_limbs(r, u, m, s);
+    }
+}
+
+// a[0..n] /= d in place, returns the remainder. the division goes by the normalized divisor,
+// the remainder is kept shifted along with it
+static limb_t divrem_small(limb_t* a, size_t n, limb_t d) {
+    STATS_TIER(DIV_SMALL);
+    unsigned s = leading_zeros(d);
+    limb_divisor divisor(d << s);
+    limb_t rem = 0;
+    for (size_t i = n; i > 0; i--) {
+        limb_t x = a[i - 1];
+        limb_t hi = rem | static_cast<limb_t>((static_cast<uint128_t>(x) << s) >> LIMB_BITS);
+        a[i - 1] = divisor.divide(hi, x << s, rem);
+    }
+    return rem >> s;
+}
+
+// a[0..n] mod d
+static limb_t mod_limbs_small(limb_t const* a, size_t n, limb_t d) {
+    STATS_TIER(DIV_SMALL);
+    unsigned s = leading_zeros(d);
+    limb_divisor divisor(d << s);
+    limb_t rem = 0;
+    for (size_t i = n; i > 0; i--) {
+        limb_t x = a[i - 1];
+        limb_t hi = rem | static_cast<limb_t>((static_cast<uint128_t>(x) << s) >> LIMB_BITS);
+        divisor.divide(hi, x << s, rem);
+    }
+    return rem >> s;
+}
+
+// r[0..n] = a[0..len] mod m[0..n], m[n-1] != 0. x is the reciprocal of normalized m and v
+// normalized m itself, if they're known
+static void mod_limbs(limb_t* r, limb_t const* a, size_t len, limb_t const* m, size_t n,
+                      limb_t const* x = nullptr, limb_t const* v = nullptr) {
+    if (len < n) {
+        std::copy(a, a + len, r);
+        std::fill(r + len, r + n, 0);
+    } else if (n == 1) {
+        r[0] = mod_limbs_small(a, len, m[0]);
+    } else {
+        scratch_frame frame;
+        limb_t* q = scratch.take(len - n + 2);
+        divrem_limbs(q, r, a, len, m, n, x, v);
+    }
+}
+
+// x[0..n] = m^(-1) modulo B^n, m[0..n] is odd. every newton step doubles the correct limbs:
+// if m x = 1 + B^len h, then m (x - B^len x h) = 1 modulo B^2len
+static void inverse_mod_power(limb_t* x, limb_t const* m, size_t n) {
+    scratch_frame frame;
+    limb_t* e = scratch.take(2 * n);
+    limb_t* t = scratch.take(2 * n);
+    x[0] = inverse_limb(m[0]);
+    for (size_t len = 1; len < n;) {
+        size_t next = std::min(2 * len, n);
+        mul_limbs(e, m, next, x, len);
+        mul_limbs(t, x, next - len, e + len, next - len);
+        std::copy(t, t + next - len, x + len);
+        negate(x + len, next - len);
+        len = next;
+    }
+}
+
+// arithmetic modulo odd m[0..n] on numbers in montgomery form x R mod m, R = B^n.
+// a product is reduced by adding such multiple of m that the low n limbs become zero
+class montgomery {
+public:
+    montgomery(limb_t const* m, size_t n) : mod(m, m + n), one_form(n), minv(-inverse_limb(m[0])) {
+        if (n >= REDC_THRESHOLD) {
+            mprime.resize(n);
+            inverse_mod_power(mprime.data(), m, n);
+            negate(mprime.data(), n);
+        }
+        limb_t one = 1;
+        to_form(one_form.data(), &one, 1);
+    }
+
+    size_t size() const {
+        return mod.size();
+    }
+
+    // res = a * b / R mod m, res may be a or b
+    void mul(limb_t* res, limb_t const* a, limb_t const* b) const {
+        scratch_frame frame;
+        limb_t* t = scratch.take(2 * size());
+        mul_limbs(t, a, size(), b, size());
+        redc(res, t);
+    }
+
+    void sqr(limb_t* res, limb_t const* a) const {
+        scratch_frame frame;
+        limb_t* t = scratch.take(2 * size());
+        sqr_limbs(t, a, size());
+        redc(res, t);
+    }
+
+    // res = x[0..len] R mod m
+    void to_form(limb_t* res, limb_t const* x, size_t len) const {
+        size_t n = size();
+        scratch_frame frame;
+        limb_t* t = scratch.take(n + len);
+        std::fill(t, t + n, 0);
+        std::copy(x, x + len, t + n);
+        mod_limbs(res, t, n + len, mod.data(), n);
+    }
+
+    void from_form(limb_t* res, limb_t const* a) const {
+        size_t n = size();
+        scratch_frame frame;
+        limb_t* t = scratch.take(2 * n);
+        std::copy(a, a + n, t);
+        std::fill(t + n, t + 2 * n, 0);
+        redc(res, t);
+    }
+
+    void one(limb_t* res) const {
+        std::copy(one_form.begin(), one_form.end(), res);
+    }
+
+private:
+    // res[0..n] = t[0..2n] / R mod m, t < m R is destroyed
+    void redc(limb_t* res, limb_t* t) const {
+        size_t n = size();
+        limb_t const* m = mod.data();
+        limb_t carry;
+        if (n < REDC_THRESHOLD) {
+            // t[i] becomes zero, so it keeps the carry out of its step until the end
+            for (size_t i = 0; i < n; i++) {
+                t[i] = kernels().addmul_1(t + i, m, n, t[i] * minv);
+            }
+            carry = kernels().add_n(res, t + n, t, n);
+        } else {
+            // q = t m' mod R, the low halves of t and q m add up to R unless t is zero there
+            scratch_frame frame;
+            limb_t* q = scratch.take(2 * n);
+            limb_t* v = scratch.take(2 * n);
+            mul_limbs(q, t, n, mprime.data(), n);
+            mul_limbs(v, q, n, m, n);
+            carry = kernels().add_n(res, t + n, v + n, n);
+            if (!is_zero_limbs(t, n)) {
+                carry += add_to(res, n, &ONE, 1);
+            }
+        }
+        // the result is below 2m
+        if (carry != 0 || compare_limbs(res, m, n) >= 0) {
+            kernels().sub_n(res, res, m, n);
+        }
+    }
+
+    std::vector<limb_t> mod;
+    std::vector<limb_t> one_form;
+    // -m^(-1) modulo B, and modulo R for the long moduli
+    limb_t minv;
+    std::vector<limb_t> mprime;
+};
+
+// arithmetic modulo m[0..n] reduced by division, for even moduli. v is normalized m and x its
+// reciprocal or null, all belong to a barrett_reducer
+class division_reducer {
+public:
+    division_reducer(limb_t const* m, limb_t const* v, limb_t const* x, size_t n)
+        : mod(m), normalized(v), inverse(x), n(n) {}
+
+    size_t size() const {
+        return n;
+    }
+
+    void mul(limb_t* res, limb_t const* a, limb_t const* b) const {
+        scratch_frame frame;
+        limb_t* t = scratch.take(2 * n);
+        mul_limbs(t, a, n, b, n);
+        reduce(res, t);
+    }
+
+    void sqr(limb_t* res, limb_t const* a) const {
+        scratch_frame frame;
+        limb_t* t = scratch.take(2 * n);
+        sqr_limbs(t, a, n);
+        reduce(res, t);
+    }
+
+    void to_form(limb_t* res, limb_t const* x, size_t len) const {
+        mod_limbs(res, x, len, mod, n, inverse, normalized);
+    }
+
+    void from_form(limb_t* res, limb_t const* a) const {
+        std::copy(a, a + n, res);
+    }
+
+    void one(limb_t* res) const {
+        limb_t one = 1;
+        to_form(res, &one, 1);
+    }
+
+private:
+    void reduce(limb_t* res, limb_t const* t) const {
+        mod_limbs(res, t, 2 * n, mod, n, inverse, normalized);
+    }
+
+    limb_t const* mod;
+    limb_t const* normalized;
+    limb_t const* inverse;
+    size_t n;
+};
+
+static bool bit_at(limb_t const* a, size_t i) {
+    return ((a[i / LIMB_BITS] >> (i % LIMB_BITS)) & 1u) != 0;
+}
+
+// res[0..n] = g^e in the arithmetic of ctx, g[0..len] is an ordinary number, e[0..el] has no
+// leading zeros. the exponent is read from the top by windows of up to k bits which end
+// with a one, so only the odd powers of g are kept
+template <typename Ctx>
+static void pow_limbs(limb_t* res, limb_t const* g, size_t len, limb_t const* e, size_t el, Ctx const& ctx) {
+    static const size_t WINDOW_LIMITS[] = {8, 24, 80, 240, 672, 1792};
+    size_t n = ctx.size();
+    size_t bits = (el == 0 ? 0 : el * LIMB_BITS - leading_zeros(e[el - 1]));
+    size_t k = 1;
+    while (k <= 6 && bits > WINDOW_LIMITS[k - 1]) {
+        k++;
+    }
+
+    scratch_frame frame;
+    limb_t* powers = scratch.take(n << (k - 1));
+    limb_t* x = scratch.take(n);
+    ctx.to_form(powers, g, len);
+    if (k > 1) {
+        limb_t* g2 = scratch.take(n);
+        ctx.sqr(g2, powers);
+        for (size_t j = 1; j < (ONE << (k - 1)); j++) {
+            ctx.mul(powers + j * n, powers + (j - 1) * n, g2);
+        }
+    }
+
+    ctx.one(x);
+    bool started = false;
+    for (size_t i = bits; i > 0;) {
+        if (!bit_at(e, i - 1)) {
+            if (started) {
+                ctx.sqr(x, x);
+            }
+            i--;
+            continue;
+        }
+        size_t low = (i > k ? i - k : 0);
+        while (!bit_at(e, low)) {
+            low++;
+        }
+        size_t window = 0;
+        for (size_t j = i; j > low; j--) {
+            window = 2 * window + bit_at(e, j - 1);
+        }
+        if (started) {
+            for (size_t j = low; j < i; j++) {
+                ctx.sqr(x, x);
+            }
+            ctx.mul(x, x, powers + (window >> 1u) * n);
+        } else {
+            std::copy(powers + (window >> 1u) * n, powers + (window >> 1u) * n + n, x);
+            started = true;
+        }
+        i = low;
+    }
+    ctx.from_form(res, x);
+}
+
+// numbers of the gcd algorithms: non-negative, without zero limbs on top
+typedef std::vector<limb_t> natural;
+
+static void trim(natural& a) {
+    while (!a.empty() && a.back() == 0) {
+        a.pop_back();
+    }
+}
+
+static size_t bit_length(natural const& a) {
+    return (a.empty() ? 0 : a.size() * LIMB_BITS - leading_zeros(a.back()));
+}
+
+static int compare(natural const& a, natural const& b) {
+    if (a.size() != b.size()) {
+        return (a.size() < b.size() ? -1 : 1);
+    }
+    return compare_limbs(a.data(), b.data(), a.size());
+}
+
+static natural product(natural const& a, natural const& b) {
+    if (a.empty() || b.empty()) {
+        return natural();
+    }
+    natural res(a.size() + b.size());
+    mul_limbs(res.data(), a.data(), a.size(), b.data(), b.size());
+    trim(res);
+    return res;
+}
+
+static natural sum(natural const& a, natural const& b) {
+    natural const& longer = (a.size() < b.size() ? b : a);
+    natural const& shorter = (a.size() < b.size() ? a : b);
+    natural res(longer);
+    res.push_back(0);
+    add_to(res.data(), res.size(), shorter.data(), shorter.size());
+    trim(res);
+    return res;
+}
+
+// res = |a - b|, returns whether a < b
+static bool difference(natural& res, natural const& a, natural const& b) {
+    bool less = (compare(a, b) < 0);
+    natural const& x = (less ? b : a);
+    natural const& y = (less ? a : b);
+    res = x;
+    sub_from(res.data(), res.size(), y.data(), y.size());
+    trim(res);
+    return less;
+}
+
+static natural shifted(natural const& a, size_t bits) {
+    size_t limbs = bits / LIMB_BITS;
+    if (limbs >= a.size()) {
+        return natural();
+    }
+    natural res(a.size() - limbs);
+    shr_limbs(res.data(), a.data() + limbs, res.size(), bits % LIMB_BITS);
+    trim(res);
+    return res;
+}
+
+// a = a mod b, returns a / b
+static natural divide(natural& a, natural const& b) {
+    if (a.size() < b.size()) {
+        return natural();
+    }
+    natural q;
+    if (b.size() == 1) {
+        q = a;
+        a.assign(1, divrem_small(q.data(), q.size(), b[0]));
+    } else {
+        q.resize(a.size() - b.size() + 2);
+        natural r(b.size());
+        divrem_limbs(q.data(), r.data(), a.data(), a.size(), b.data(), b.size());
+        a.swap(r);
+    }
+    trim(a);
+    trim(q);
+    return q;
+}
+
+static unsigned trailing_zeros(uint128_t x) {
+    limb_t lo = static_cast<limb_t>(x);
+    return (lo != 0 ? __builtin_ctzll(lo) : LIMB_BITS + __builtin_ctzll(static_cast<limb_t>(x >> LIMB_BITS)));
+}
+
+// stein's algorithm: common twos aside, the odd numbers are subtracted and freed of twos
+static uint128_t binary_gcd(uint128_t a, uint128_t b) {
+    if (a == 0 || b == 0) {
+        return a | b;
+    }
+    unsigned k = trailing_zeros(a | b);
+    a >>= trailing_zeros(a);
+    while (b != 0) {
+        b >>= trailing_zeros(b);
+        if (a > b) {
+            std::swap(a, b);
+        }
+        b -= a;
+    }
+    return a << k;
+}
+
+// product of the quotient matrices [[q, 1], [1, 0]] of euclid's steps: (a, b) = M (a', b')
+// takes a pair of the remainder sequence back to an earlier one. odd tells that the
+// determinant is -1. a zero row is never updated, that's how only one row is followed
+struct gcd_matrix {
+    natural m[2][2];
+    bool odd;
+};
+
+// the row (x, y) = (x, y) S
+static void mul_row(natural& x, natural& y, gcd_matrix const& s) {
+    natural nx = sum(product(x, s.m[0][0]), product(y, s.m[1][0]));
+    y = sum(product(x, s.m[0][1]), product(y, s.m[1][1]));
+    x.swap(nx);
+}
+
+// M = M S
+static void mul_matrix(gcd_matrix& m, gcd_matrix const& s) {
+    mul_row(m.m[0][0], m.m[0][1], s);
+    mul_row(m.m[1][0], m.m[1][1], s);
+    m.odd ^= s.odd;
+}
+
+// the row (x, y) = (x, y) Q for Q of limbs q[0..4]
+static void mul_row_limbs(natural& x, natural& y, limb_t const* q) {
+    if (x.empty() && y.empty()) {
+        return;
+    }
+    // a limb for the product by q and one for the sum
+    size_t n = std::max(x.size(), y.size()) + 2;
+    x.resize(n);
+    y.resize(n);
+    scratch_frame frame;
+    limb_t* t = scratch.take(n);
+    kernels().mul_1(t, x.data(), n, q[0]);
+    kernels().addmul_1(t, y.data(), n, q[2]);
+    kernels().mul_1(y.data(), y.data(), n, q[3]);
+    kernels().addmul_1(y.data(), x.data(), n, q[1]);
+    std::copy(t, t + n, x.begin());
+    trim(x);
+    trim(y);
+}
+
+// (a, b) = (b, a mod b), a quotient of any size
+static void division_step(natural& a, natural& b, gcd_matrix* m) {
+    natural q = divide(a, b);
+    a.swap(b);
+    if (m != nullptr) {
+        for (natural* row : m->m) {
+            natural x = sum(product(row[0], q), row[1]);
+            row[1].swap(row[0]);
+            row[0].swap(x);
+        }
+        m->odd = !m->odd;
+    }
+}
+
+// 128 bits of x[0..len] from limb n - 1 down, shifted left by s
+static uint128_t top_bits(natural const& x, size_t n, unsigned s) {
+    limb_t v[3] = {};
+    for (size_t i = 0; i < 3 && i < n; i++) {
+        v[i] = (n - 1 - i < x.size() ? x[n - 1 - i] : 0);
+    }
+    if (s != 0) {
+        v[0] = (v[0] << s) | (v[1] >> (LIMB_BITS - s));
+        v[1] = (v[1] << s) | (v[2] >> (LIMB_BITS - s));
+    }
+    return (static_cast<uint128_t>(v[0]) << LIMB_BITS) | v[1];
+}
+
+// euclid's steps on the top bits a >= b of two numbers, as long as jebelean's condition shows
+// that the whole numbers take the same quotients. m[0..4] gets the matrix of the steps row by
+// row, its entries stay below B. returns the number of steps
+static size_t lehmer_quotients(uint128_t a, uint128_t b, limb_t* m) {
+    m[0] = 1;
+    m[1] = 0;
+    m[2] = 0;
+    m[3] = 1;
+    size_t steps = 0;
+    while (b != 0) {
+        uint128_t q = 1;
+        uint128_t r = a - b;
+        if (r >= b) {
+            q = a / b;
+            r = a - q * b;
+        }
+        if ((q >> LIMB_BITS) != 0) {
+            break;
+        }
+        uint128_t m00 = q * m[0] + m[1];
+        uint128_t m10 = q * m[2] + m[3];
+        if ((m00 >> LIMB_BITS) != 0 || (m10 >> LIMB_BITS) != 0) {
+            break;
+        }
+        if (r < m00 || b - r < m00 + m[0]) {
+            break;
+        }
+        m[1] = m[0];
+        m[0] = static_cast<limb_t>(m00);
+        m[3] = m[2];
+        m[2] = static_cast<limb_t>(m10);
+        a = b;
+        b = r;
+        steps++;
+    }
+    return steps;
+}
+
+// res[0..n] = c * x - d * y, or d * y - c * x if swap is set. returns false if that isn't in [0, B^n)
+static bool combine(limb_t* res, limb_t const* x, limb_t const* y, size_t n, limb_t c, limb_t d, bool swap) {
+    if (swap) {
+        std::swap(x, y);
+        std::swap(c, d);
+    }
+    limb_t hi = kernels().mul_1(res, x, n, c);
+    return kernels().submul_1(res, y, n, d) == hi;
+}
+
+// a step of lehmer's algorithm on a > b > 0: all quotients that the top 128 bits tell are
+// made at once by linear combinations of a and b, or a division if there are none
+static void lehmer_step(natural& a, natural& b, gcd_matrix* m) {
+    size_t n = a.size();
+    unsigned s = leading_zeros(a.back());
+    limb_t q[4];
+    size_t steps = lehmer_quotients(top_bits(a, n, s), top_bits(b, n, s), q);
+    if (steps == 0) {
+        division_step(a, b, m);
+        return;
+    }
+    scratch_frame frame;
+    limb_t* y = scratch.take(n);
+    std::copy(b.begin(), b.end(), y);
+    std::fill(y + b.size(), y + n, 0);
+    // (a, b) = Q (a', b') for Q of determinant (-1)^steps
+    bool odd = (steps % 2 == 1);
+    limb_t* na = scratch.take(n);
+    limb_t* nb = scratch.take(n);
+    if (!combine(na, a.data(), y, n, q[3], q[1], odd) || !combine(nb, y, a.data(), n, q[0], q[2], odd) ||
+        compare_limbs(na, nb, n) <= 0) {
+        division_step(a, b, m);
+        return;
+    }
+    a.assign(na, na + n);
+    b.assign(nb, nb + n);
+    trim(a);
+    trim(b);
+    if (m != nullptr) {
+        mul_row_limbs(m->m[0][0], m->m[0][1], q);
+        mul_row_limbs(m->m[1][0], m->m[1][1], q);
+        m->odd ^= odd;
+    }
+}
+
+// the lowest bits of a
+static natural low_bits(natural const& a, size_t bits) {
+    natural res(a.begin(), a.begin() + std::min(a.size(), (bits + LIMB_BITS - 1) / LIMB_BITS));
+    if (res.size() * LIMB_BITS > bits) {
+        res.back() &= (limb_t(1) << (bits % LIMB_BITS)) - 1;
+    }
+    trim(res);
+    return res;
+}
+
+// res = top 2^p + x or top 2^p - x, returns false if that's negative
+static bool attach_low(natural& res, natural const& top, size_t p, natural const& x, bool negative) {
+    size_t limbs = p / LIMB_BITS;
+    res.assign(std::max(top.size() + limbs + 1, x.size() + 1), 0);
+    res[top.size() + limbs] = shl_limbs(res.data() + limbs, top.data(), top.size(), p % LIMB_BITS);
+    if (!negative) {
+        add_to(res.data(), res.size(), x.data(), x.size());
+    } else if (sub_from(res.data(), res.size(), x.data(), x.size()) != 0) {
+        return false;
+    }
+    trim(res);
+    return true;
+}
+
+// (a, b) = S^(-1) (a, b), if that gives a > b >= 0, where S reduced the bits of a and b from p
+// on to ta and tb: only the low p bits are left to be multiplied by S^(-1). otherwise nothing
+// changes and false is returned
+static bool reduce_by(natural& a, natural& b, gcd_matrix const& s, natural const& ta,
+                      natural const& tb, size_t p) {
+    natural al = low_bits(a, p);
+    natural bl = low_bits(b, p);
+    natural x, na, nb;
+    bool neg = difference(x, product(s.m[1][1], al), product(s.m[0][1], bl));
+    if (!attach_low(na, ta, p, x, neg != s.odd)) {
+        return false;
+    }
+    neg = difference(x, product(s.m[0][0], bl), product(s.m[1][0], al));
+    if (!attach_low(nb, tb, p, x, neg != s.odd) || compare(na, nb) <= 0) {
+        return false;
+    }
+    a.swap(na);
+    b.swap(nb);
+    return true;
+}
+
+// the quotients of a reduction of the top bits are checked on the whole numbers, the top is
+// reduced a bit less than halfway for them to be right almost always
+static const size_t HGCD_MARGIN = 2 * LIMB_BITS;
+
+// a > b are reduced along euclid's remainder sequence until b has at most s bits (or somewhat
+// fewer), M collects the steps if it's given. the quotients down to s bits depend on the top
+// 2 (n - s) bits only: those are reduced by recursion and the matrix is applied to the whole
+// numbers. a way of more than a quarter of the length is made in two halves, that's the
+// half-gcd of schonhage with O(M(n) log n) operations
+static void half_gcd(natural& a, natural& b, size_t s, gcd_matrix* m) {
+    while (bit_length(b) > s) {
+        size_t n = bit_length(a);
+        size_t d = n - s;
+        if (a.size() < HGCD_THRESHOLD || d <= 2 * HGCD_MARGIN) {
+            STATS_TIER(GCD_LEHMER);
+            lehmer_step(a, b, m);
+        } else if (2 * d + 4 * HGCD_MARGIN <= n) {
+            STATS_TIER(GCD_HALF);
+            natural ta = shifted(a, n - 2 * d);
+            natural tb = shifted(b, n - 2 * d);
+            gcd_matrix r = {{{{1}, {}}, {{}, {1}}}, false};
+            half_gcd(ta, tb, d + HGCD_MARGIN, &r);
+            if (!r.m[0][1].empty() && reduce_by(a, b, r, ta, tb, n - 2 * d)) {
+                if (m != nullptr) {
+                    mul_matrix(*m, r);
+                }
+            } else {
+                division_step(a, b, m);
+            }
+        } else if (bit_length(b) > n - d / 2) {
+            half_gcd(a, b, n - d / 2, m);
+        } else {
+            // a huge quotient took b past the first half already
+            division_step(a, b, m);
+        }
+    }
+}
+
+// a = gcd(a, b) for a >= b, b becomes zero. M collects the steps if it's given
+static void gcd_naturals(natural& a, natural& b, gcd_matrix* m) {
+    while (!b.empty()) {
+        if (a.size() > b.size() + 1) {
+            division_step(a, b, m);
+        } else if (b.size() >= HGCD_THRESHOLD) {
+            half_gcd(a, b, bit_length(a) / 2, m);
+        } else if (m == nullptr && a.size() <= 2) {
+            STATS_TIER(GCD_BINARY);
+            uint128_t g = binary_gcd(top_bits(a, 2, 0), top_bits(b, 2, 0));
+            a = {static_cast<limb_t>(g), static_cast<limb_t>(g >> LIMB_BITS)};
+            trim(a);
+            b.clear();
+        } else {
+            STATS_TIER(GCD_LEHMER);
+            lehmer_step(a, b, m);
+        }
+    }
+}
+
+// a = gcd(a, b) for a >= b, and the cofactor of a (or of b, if of_b is set) in the
+// combination that gives it: its magnitude c and its sign
+static void gcd_cofactor(natural& a, natural& b, bool of_b, natural& c, bool& negative) {
+    // the row of the matrix that gives the cofactor is followed, the other one stays zero
+    gcd_matrix m = {{{{}, {}}, {{}, {}}}, false};
+    m.m[of_b ? 0 : 1][of_b ? 0 : 1] = {1};
+    gcd_naturals(a, b, &m);
+    // gcd = det (m11 a - m01 b)
+    c = m.m[of_b ? 0 : 1][1];
+    negative = (m.odd != of_b);
+}
+
+// x^e by squarings from the top bit of e
+static natural power(natural const& x, unsigned e) {
+    if (e == 0) {
+        return natural(1, 1);
+    }
+    natural res = x;
+    for (int i = 30 - __builtin_clz(e); i >= 0; i--) {
+        res = product(res, res);
+        if ((e >> i) & 1) {
+            res = product(res, x);
+        }
+    }
+    return res;
+}
+
+// a / b for b > 0, without the remainder
+static natural quotient(natural const& a, natural const& b) {
+    if (a.size() < b.size()) {
+        return natural();
+    }
+    natural q;
+    if (b.size() == 1) {
+        q = a;
+        divrem_small(q.data(), q.size(), b[0]);
+    } else {
+        q.resize(a.size() - b.size() + 2);
+        divrem_limbs(q.data(), nullptr, a.data(), a.size(), b.data(), b.size());
+    }
+    trim(q);
+    return q;
+}
+
+static void decrement(natural& x) {
+    sub_from(x.data(), x.size(), natural(1, 1).data(), 1);
+    trim(x);
+}
+
+// a^(1/n) for a > 0 by floating point, to about 45 bits
+static double root_estimate(natural const& a, unsigned n) {
+    limb_t top = static_cast<limb_t>(top_bits(a, a.size(), leading_zeros(a.back())) >> LIMB_BITS);
+    double drop = static_cast<double>(a.size() * LIMB_BITS - LIMB_BITS);
+    return std::exp2((std::log2(static_cast<double>(top)) + drop - leading_zeros(a.back())) / n);
+}
+
+// ((n - 1) x + a / x^(n - 1)) / n for x > 0: by the means inequality it's never below the n-th
+// root of a, it goes down to the root from above
+static natural newton_root_step(natural const& a, natural const& x, unsigned n) {
+    natural q = quotient(a, power(x, n - 1));
+    natural res(std::max(x.size() + 1, q.size()) + 1);
+    res[x.size()] = kernels().mul_1(res.data(), x.data(), x.size(), n - 1);
+    add_to(res.data(), res.size(), q.data(), q.size());
+    divrem_small(res.data(), res.size(), n);
+    trim(res);
+    return res;
+}
+
+// floor(a^(1/n)) for a > 0 of the given length in bits and n >= 2, or maybe that + 1 unless
+// exact is set. the top half of the root is the root of the top bits of a, then one newton step
+// from just above doubles the correct bits and leaves the root or the root + 1. only the last
+// step is checked by the power. roots of up to a limb start from the floating point estimate
+// instead, a step is needed only past its precision
+static natural root_natural(natural const& a, size_t bits, unsigned n, bool exact = true) {
+    // a < 2^n, the check of an estimate of 2 would take a power of n bits
+    if (n >= bits) {
+        return natural(1, 1);
+    }
+    size_t root_bits = (bits - 1) / n + 1;
+    natural x;
+    if (root_bits <= LIMB_BITS) {
+        uint128_t e = static_cast<uint128_t>(root_estimate(a, n) * (1 + 1e-12)) + 1;
+        x = {static_cast<limb_t>(e), static_cast<limb_t>(e >> LIMB_BITS)};
+        trim(x);
+        if (root_bits > 40) {
+            x = newton_root_step(a, x, n);
+        }
+        exact = true;
+    } else {
+        // x = (r + 1) 2^k is at most 2^(k + 1) above the root, a step leaves
+        // (n - 1) 4^(k + 1) / 2^root_bits of that: less than a half for this k
+        unsigned n_bits = 32 - __builtin_clz(n);
+        size_t k = (root_bits - n_bits - 3) / 2;
+        natural r = root_natural(shifted(a, n * k), bits - n * k, n, false);
+        r.push_back(0);
+        add_to(r.data(), r.size(), natural(1, 1).data(), 1);
+        trim(r);
+        attach_low(x, r, k, natural(), false);
+        x = newton_root_step(a, x, n);
+    }
+    while (exact && compare(power(x, n), a) > 0) {
+        decrement(x);
+    }
+    return x;
+}
+
+static bool is_small_prime(uint32_t x) {
+    if (x < 4) {
+        return x > 1;
+    }
+    if (x % 2 == 0) {
+        return false;
+    }
+    for (uint32_t d = 3; d <= x / d; d += 2) {
+        if (x % d == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// b^e mod m for m < 2^32
+static limb_t pow_small(limb_t b, limb_t e, limb_t m) {
+    limb_t res = 1 % m;
+    for (b %= m; e != 0; e >>= 1) {
+        if (e & 1) {
+            res = res * b % m;
+        }
+        b = b * b % m;
+    }
+    return res;
+}
+
+// divides a by q as long as it goes, returns how many times it did
+static size_t remove_factor(natural& a, limb_t q) {
+    size_t times = 0;
+    for (natural y = a; divrem_small(y.data(), y.size(), q) == 0; y = a) {
+        trim(y);
+        a.swap(y);
+        times++;
+    }
+    return times;
+}
+
+// r[i] = a mod q[i] for primes q[i] < 2^32. a is reduced modulo their product first: a pass over
+// it by a divisor of many limbs costs about as much as one by a single limb. the remainder is
+// passed over once for every group of primes that fits into a limb
+static void residues(natural const& a, std::vector<limb_t> const& q, limb_t* r) {
+    natural m(1, 1);
+    for (limb_t x : q) {
+        limb_t carry = kernels().mul_1(m.data(), m.data(), m.size(), x);
+        if (carry != 0) {
+            m.push_back(carry);
+        }
+    }
+    natural rem(a);
+    divide(rem, m);
+    for (size_t begin = 0, end = 0; begin < q.size(); begin = end) {
+        limb_t group = 1;
+        for (; end < q.size() && group <= LIMB_MAX / q[end]; end++) {
+            group *= q[end];
+        }
+        limb_t g = (rem.empty() ? 0 : mod_limbs_small(rem.data(), rem.size(), group));
+        for (size_t i = begin; i < end; i++) {
+            r[i] = g % q[i];
+        }
+    }
+}
+
+// the primes p of exps that a may be a power of by its residues modulo primes q = 1 (mod p):
+// those of a p-th power are zero or have a^((q - 1) / p) = 1, other numbers pass with the
+// chance 1 / p for every q. every p gets primes enough for the chance of about 1 / 1000.
+// the primes are taken from 2^16 on, above the ones perfect_power divides out
+static std::vector<unsigned> power_candidates(natural const& a, std::vector<unsigned> const& exps) {
+    std::vector<unsigned> res;
+    std::vector<limb_t> q;
+    std::vector<limb_t> r;
+    std::vector<size_t> owner;
+    for (size_t i = 0; i < exps.size(); i++) {
+        unsigned p = exps[i];
+        if (p >= (1u << 24)) {
+            continue;
+        }
+        limb_t c = (1u << 16) / (2 * p) * (2 * p) + 1;
+        for (limb_t chance = 1; chance < 1000; chance *= p) {
+            do {
+                c += 2 * p;
+            } while (!is_small_prime(static_cast<uint32_t>(c)));
+            q.push_back(c);
+            owner.push_back(i);
+        }
+    }
+    // batches of 128 primes, about 40 limbs
+    r.resize(q.size());
+    std::vector<bool> rejected(exps.size());
+    for (size_t begin = 0; begin < q.size(); begin += 128) {
+        size_t end = std::min(q.size(), begin + 128);
+        residues(a, std::vector<limb_t>(q.begin() + begin, q.begin() + end), r.data() + begin);
+    }
+    for (size_t j = 0; j < q.size(); j++) {
+        unsigned p = exps[owner[j]];
+        if (r[j] != 0 && pow_small(r[j], (q[j] - 1) / p, q[j]) != 1) {
+            rejected[owner[j]] = true;
+        }
+    }
+    for (size_t i = 0; i < exps.size(); i++) {
+        if (!rejected[i]) {
+            res.push_back(exps[i]);
+        }
+    }
+    return res;
+}
+
+// the odd primes up to n, by the sieve of eratosthenes over odd numbers
+static std::vector<limb_t> odd_primes(limb_t n) {
+    std::vector<limb_t> res;
+    std::vector<bool> composite(n / 2 + 1);
+    for (limb_t p = 3; p <= n; p += 2) {
+        if (!composite[p / 2]) {
+            res.push_back(p);
+            for (limb_t q = p * p; q <= n; q += 2 * p) {
+                composite[q / 2] = true;
+            }
+        }
+    }
+    return res;
+}
+
+// the product of small factors: as many as fit are multiplied in a limb, the limbs by a tree
+static big_integer product_of_small(std::vector<limb_t> const& factors) {
+    std::vector<big_integer> limbs;
+    limb_t acc = 1;
+    for (limb_t f : factors) {
+        if (acc > LIMB_MAX / f) {
+            limbs.push_back(big_integer(static_cast<unsigned long long>(acc)));
+            acc = 1;
+        }
+        acc *= f;
+    }
+    limbs.push_back(big_integer(static_cast<unsigned long long>(acc)));
+    return product(std::move(limbs));
+}
+
+// the product of primes[i]^e[i] by the bits of the exponents from the top: the result so far is
+// squared and multiplied by the product of the primes with the next bit set. so the long
+// products are squares, and every prime goes into as many products as its exponent has bits
+static big_integer prime_power_product(std::vector<limb_t> const& primes, std::vector<limb_t> const& e) {
+    limb_t all = 0;
+    for (limb_t x : e) {
+        all |= x;
+    }
+    big_integer res = 1;
+    for (int b = (all == 0 ? -1 : 63 - __builtin_clzll(all)); b >= 0; b--) {
+        res = square(res);
+        std::vector<limb_t> group;
+        for (size_t i = 0; i < primes.size(); i++) {
+            if ((e[i] >> b) & 1) {
+                group.push_back(primes[i]);
+            }
+        }
+        res *= product_of_small(group);
+    }
+    return res;
+}
+
+// the power of p in n!, by legendre's formula
+static limb_t factorial_exponent(limb_t n, limb_t p) {
+    limb_t e = 0;
+    for (; n != 0; n /= p) {
+        e += n / p;
+    }
+    return e;
+}
+
+// 10^(19 * 2^k) with the reciprocal of its normalized value for the long ones, kept per
+// thread as the limb stack. moving the outer vector doesn't move the limbs, so given pointers stay valid
+struct decimal_power {
+    std::vector<limb_t> value;
+    std::vector<limb_t> inverse;
+};
+
+static decimal_power& power_of_ten(size_t k) {
+    static thread_local std::vector<decimal_power> powers;
+    while (powers.size() <= k) {
+        decimal_power p;
+        if (powers.empty()) {
+            p.value.push_back(DEC_BASE);
+        } else {
+            std::vector<limb_t> const& prev = powers.back().value;
+            p.value.resize(2 * prev.size());
+            sqr_limbs(p.value.data(), prev.data(), prev.size());
+            if (p.value.back() == 0) {
+                p.value.pop_back();
+            }
+        }
+        powers.push_back(std::move(p));
+    }
+    return powers[k];
+}
+
+// the reciprocal is found on the first division by the power
+static limb_t const* power_inverse(decimal_power& p) {
+    size_t n = p.value.size();
+    if (n < NEWTON_THRESHOLD) {
+        return nullptr;
+    }
+    if (p.inverse.empty()) {
+        scratch_frame frame;
+        limb_t* v = scratch.take(n);
+        shl_limbs(v, p.value.data(), n, leading_zeros(p.value.back()));
+        p.inverse.resize(n + 1);
+        reciprocal(p.inverse.data(), v, n);
+    }
+    return p.inverse.data();
+}
+
+// appends nineteen-digit chunks of a[0..n] (destroyed) to out, padded with zeros to width digits
+static void to_decimal_basecase(std::string& out, limb_t* a, size_t n, size_t width) {
+    scratch_frame frame;
+    limb_t* chunks = scratch.take(2 * n + 1);
+    size_t count = 0;
+    while (n > 0) {
+        chunks[count++] = divrem_small(a, n, DEC_BASE);
+        while (n > 0 && a[n - 1] == 0) {
+            n--;
+        }
+    }
+    if (count == 0) {
+        out.append(width, '0');
+        return;
+    }
+    char buf[DEC_DIGITS];
+    size_t top = DEC_DIGITS;
+    for (limb_t x = chunks[count - 1]; x != 0; x /= 10) {
+        buf[--top] = static_cast<char>('0' + x % 10);
+    }
+    size_t len = DEC_DIGITS * count - top;
+    if (width > len) {
+        out.append(width - len, '0');
+    }
+    out.append(buf + top, DEC_DIGITS - top);
+    for (size_t i = count - 1; i > 0; i--) {
+        limb_t x = chunks[i - 1];
+        for (size_t j = DEC_DIGITS; j > 0; j--) {
+            buf[j - 1] = static_cast<char>('0' + x % 10);
+            x /= 10;
+        }
+        out.append(buf, DEC_DIGITS);
+    }
+}
+
+// appends a[0..n] to out, padded with zeros to width digits: the number is split by
+// the largest cached power of ten not longer than its half, both parts are converted alone
+static void to_decimal(std::string& out, limb_t const* a, size_t n, size_t width) {
+    scratch_frame frame;
+    while (n > 0 && a[n - 1] == 0) {
+        n--;
+    }
+    if (n < TO_STRING_THRESHOLD) {
+        limb_t* t = scratch.take(n + 1);
+        std::copy(a, a + n, t);
+        to_decimal_basecase(out, t, n, width);
+        return;
+    }
+    size_t k = 0;
+    while (2 * power_of_ten(k + 1).value.size() <= n + 1) {
+        k++;
+    }
+    decimal_power& p = power_of_ten(k);
+    size_t m = p.value.size();
+    size_t low = DEC_DIGITS << k;
+    limb_t* q = scratch.take(n - m + 2);
+    limb_t* r = scratch.take(m);
+    divrem_limbs(q, r, a, n, p.value.data(), m, power_inverse(p));
+    to_decimal(out, q, n - m + 2, (width > low ? width - low : 0));
+    to_decimal(out, r, m, low);
+}
+
+// a[0..n] = a * x + c, returns the carry
+static limb_t mul_add_small(limb_t* a, size_t n, limb_t x, limb_t c) {
+    limb_t carry = c;
+    for (size_t i = 0; i < n; i++) {
+        uint128_t t = static_cast<uint128_t>(a[i]) * x + carry;
+        a[i] = static_cast<limb_t>(t);
+        carry = static_cast<limb_t>(t >> LIMB_BITS);
+    }
+    return carry;
+}
+
+// limbs enough for len decimal digits: a chunk of nineteen digits is less than a limb
+static size_t decimal_limbs(size_t len) {
+    return len / DEC_DIGITS + 2;
+}
+
+// res[0..] = the digits s[0..len] by nineteen at once, returns the length
+static size_t from_decimal_basecase(limb_t* res, char const* s, size_t len) {
+    size_t n = 0;
+    size_t step = (len % DEC_DIGITS == 0 ? DEC_DIGITS : len % DEC_DIGITS);
+    for (size_t i = 0; i < len; i += step, step = DEC_DIGITS) {
+        limb_t x = 0;
+        limb_t scale = 1;
+        for (size_t j = i; j < i + step; j++) {
+            x = x * 10 + static_cast<limb_t>(s[j] - '0');
+            scale *= 10;
+        }
+        limb_t carry = mul_add_small(res, n, scale, x);
+        if (carry != 0) {
+            res[n++] = carry;
+        }
+    }
+    return n;
+}
+
+// res[0..decimal_limbs(len)] = the digits s[0..len], returns the length: the lower
+// 19 * 2^k digits (at least half) and the rest are parsed alone, then joined by a cached power of ten
+static size_t from_decimal(limb_t* res, char const* s, size_t len) {
+    if (len < FROM_STRING_THRESHOLD * DEC_DIGITS) {
+        return from_decimal_basecase(res, s, len);
+    }
+    scratch_frame frame;
+    size_t k = 0;
+    while ((DEC_DIGITS << (k + 1)) < len) {
+        k++;
+    }
+    size_t low = DEC_DIGITS << k;
+    limb_t* hi = scratch.take(decimal_limbs(len - low));
+    limb_t* lo = scratch.take(decimal_limbs(low));
+    size_t hn = from_decimal(hi, s, len - low);
+    size_t ln = from_decimal(lo, s + len - low, low);
+    if (hn == 0) {
+        std::copy(lo, lo + ln, res);
+        return ln;
+    }
+    std::vector<limb_t> const& p = power_of_ten(k).value;
+    size_t n = hn + p.size();
+    mul_limbs(res, hi, hn, p.data(), p.size());
+    add_to(res, n, lo, ln);
+    while (n > 0 && res[n - 1] == 0) {
+        n--;
+    }
+    return n;
+}
+
+limb_buffer::limb_buffer() noexcept : size_(0), capacity(INLINE_LIMBS) {
+}
+
+limb_buffer::limb_buffer(limb_buffer const& other) : limb_buffer() {
+    *this = other;
+}
+
+limb_buffer::limb_buffer(limb_buffer&& other) noexcept : limb_buffer() {
+    swap(other);
+}
+
+limb_buffer::~limb_buffer() {
+    if (!is_inline()) {
+        delete[] big;
+    }
+}
+
+limb_buffer& limb_buffer::operator=(limb_buffer const& other) {
+    if (this != &other) {
+        size_ = 0;
+        if (capacity < other.size_) {
+            reallocate(other.size_);
+        }
+        size_ = other.size_;
+        std::copy(other.begin(), other.end(), data());
+    }
+    return *this;
+}
+
+limb_buffer& limb_buffer::operator=(limb_buffer&& other) noexcept {
+    limb_buffer tmp(std::move(other));
+    swap(tmp);
+    return *this;
+}
+
+void limb_buffer::resize(size_t n) {
+    if (n > capacity) {
+        reallocate(std::max(n, 2 * static_cast<size_t>(capacity)));
+    }
+    if (n > size_) {
+        std::fill(data() + size_, data() + n, 0);
+    }
+    size_ = static_cast<uint32_t>(n);
+}
+
+void limb_buffer::push_back(limb_t x) {
+    if (size_ == capacity) {
+        reallocate(2 * static_cast<size_t>(capacity));
+    }
+    data()[size_++] = x;
+}
+
+// heap buffers are exchanged, inline limbs are copied as far as they are used
+void limb_buffer::swap(limb_buffer& other) noexcept {
+    if (!is_inline() && !other.is_inline()) {
+        std::swap(big, other.big);
+    } else if (is_inline() && other.is_inline()) {
+        limb_t t[INLINE_LIMBS];
+        std::copy(small, small + size_, t);
+        std::copy(other.small, other.small + other.size_, small);
+        std::copy(t, t + size_, other.small);
+    } else {
+        limb_buffer& heap = (is_inline() ? other : *this);
+        limb_buffer& local = (is_inline() ? *this : other);
+        limb_t* p = heap.big;
+        std::copy(local.small, local.small + local.size_, heap.small);
+        local.big = p;
+    }
+    std::swap(size_, other.size_);
+    std::swap(capacity, other.capacity);
+}
+
+void limb_buffer::reallocate(size_t new_capacity) {
+    limb_t* p = new limb_t[new_capacity];
+    STATS_ALLOCATION(new_capacity);
+    std::copy(begin(), end(), p);
+    if (!is_inline()) {
+        delete[] big;
+    }
+    big = p;
+    capacity = static_cast<uint32_t>(new_capacity);
+}
+
+big_integer::big_integer() : sign(false) {
+}
+
+big_integer::big_integer(big_integer const& other) = default;
+
+big_integer::big_integer(big_integer&& other) noexcept : sign(other.sign), ranks(std::move(other.ranks)) {
+    other.ranks.clear();
+    other.sign = false;
+}
+
+big_integer::big_integer(unsigned long long a) : sign(false) {
+    push_el(a);
+}
+
+big_integer::big_integer(int a) : big_integer(static_cast<signed long long>(a)) {
+}
+
+big_integer::big_integer(signed long a) : big_integer(static_cast<signed long long>(a)){
+}
+
+big_integer::big_integer(unsigned long a) : big_integer(static_cast<unsigned long long>(a)){
+}
+
+// we don't know pb quantity
+big_integer::big_integer(signed long long a) : sign(a < 0) {
+    unsigned long long x;
+    if (a < 0) {
+        a++;
+        x = static_cast<unsigned long long>(-a) + 1ULL;
+    } else {
+        x = static_cast<unsigned long long>(a);
+    }
+    push_el(x);
+}
+
+big_integer::big_integer(uint32_t a) : big_integer(static_cast<unsigned long long>(a)){
+}
+
+big_integer::big_integer(std::string const& str) : big_integer(){
+    STATS_OPERATION(FROM_STRING);
+    size_t len = str.length();
+    size_t start = ((str[0] == '-') || (str[0] == '+') ? 1 : 0);
+    if (start >= len) {
+        throw std::invalid_argument("Wrong string");
+    }
+    for (size_t i = start; i < len; i++) {
+        if ((str[i] < '0') || (str[i] > '9')) {
+            throw std::invalid_argument("Wrong string");
+        }
+    }
+    while (start + 1 < len && str[start] == '0') {
+        start++;
+    }
+    ranks.resize(decimal_limbs(len - start));
+    ranks.resize(from_decimal(ranks.data(), str.data() + start, len - start));
+    sign = (str[0] == '-');
+    pull_zero();
+}
+
+big_integer::~big_integer() = default;
+
+big_integer& big_integer::operator=(big_integer const& other) = default;
+
+big_integer& big_integer::operator=(big_integer&& other) noexcept {
+    big_integer tmp(std::move(other));
+    swap(tmp);
+    return *this;
+}
+
+// *this += b[0..m] taken with the sign b_sign: magnitudes are added, or the smaller one
+// is subtracted from the larger in place. b may be the limbs of *this
+void big_integer::add_signed(limb_t const* b, size_t m, bool b_sign) {
+    STATS_OPERATION(ADD);
+    size_t n = ranks.size();
+    if (m == 0) {
+        return;
+    }
+    if (n == 0 || sign == b_sign) {
+        sign = b_sign;
+        if (n < m) {
+            ranks.resize(m);
+        }
+        push_el(add_to(ranks.data(), ranks.size(), b, m));
+        return;
+    }
+    if (n > m || (n == m && compare_limbs(ranks.data(), b, n) >= 0)) {
+        sub_from(ranks.data(), n, b, m);
+    } else {
+        ranks.resize(m);
+        sub_reverse(ranks.data(), b, m);
+        sign = b_sign;
+    }
+    pull_zero();
+}
+
+// values of int64_t are computed natively while the result fits, the limbs are used otherwise
+bool big_integer::to_int64(int64_t& x) const {
+    size_t n = ranks.size();
+    if (n > 1) {
+        return false;
+    }
+    uint64_t mag = (n > 0 ? ranks[0] : 0);
+    if (mag > static_cast<uint64_t>(INT64_MAX)) {
+        return false;
+    }
+    x = (sign ? -static_cast<int64_t>(mag) : static_cast<int64_t>(mag));
+    return true;
+}
+
+void big_integer::assign_int64(int64_t x) {
+    sign = (x < 0);
+    uint64_t mag = (sign ? 0 - static_cast<uint64_t>(x) : static_cast<uint64_t>(x));
+    ranks.clear();
+    push_el(mag);
+}
+
+big_integer& big_integer::operator+=(big_integer const& rhs) {
+    int64_t x, y, z;
+    if (to_int64(x) && rhs.to_int64(y) && !__builtin_add_overflow(x, y, &z)) {
+        assign_int64(z);
+        return *this;
+    }
+    add_signed(rhs.ranks.data(), rhs.ranks.size(), rhs.sign);
+    return *this;
+}
+
+big_integer& big_integer::operator-=(big_integer const& rhs) {
+    int64_t x, y, z;
+    if (to_int64(x) && rhs.to_int64(y) && !__builtin_sub_overflow(x, y, &z)) {
+        assign_int64(z);
+        return *this;
+    }
+    add_signed(rhs.ranks.data(), rhs.ranks.size(), !rhs.sign);
+    return *this;
+}
 
-big_integer::big_integer() : ranks({}), sign(false) {
+// the overloads with built-in integers: the int64_t path is tried first, then the limbs
+// of the magnitude are used as a short number
+big_integer& big_integer::add_int(uint64_t mag, bool negative) {
+    int64_t x, z;
+    if (mag <= static_cast<uint64_t>(INT64_MAX) && to_int64(x)
+        && !__builtin_add_overflow(x, (negative ? -static_cast<int64_t>(mag) : static_cast<int64_t>(mag)), &z)) {
+        assign_int64(z);
+        return *this;
+    }
+    limb_t b = mag;
+    add_signed(&b, (b != 0 ? 1 : 0), negative);
+    return *this;
 }
 
-big_integer::big_integer(big_integer const& other) = default;
+big_integer& big_integer::mul_int(uint64_t mag, bool negative) {
+    STATS_OPERATION(MUL);
+    STATS_MUL(ranks.size(), 1);
+    int64_t x, z;
+    if (mag <= static_cast<uint64_t>(INT64_MAX) && to_int64(x)
+        && !__builtin_mul_overflow(x, (negative ? -static_cast<int64_t>(mag) : static_cast<int64_t>(mag)), &z)) {
+        assign_int64(z);
+        return *this;
+    }
+    push_el(kernels().mul_1(ranks.data(), ranks.data(), ranks.size(), mag));
+    sign ^= negative;
+    pull_zero();
+    return *this;
+}
 
-big_integer::big_integer(unsigned long long a) : sign(false), ranks({}){
-    if (a != 0) {
-        ranks.push_back(static_cast<uint32_t>(a));
+big_integer& big_integer::div_int(uint64_t mag, bool negative) {
+    if (mag == 0) {
+        throw std::overflow_error("Zero division");
     }
-    a >>= 32;
-    push_el(static_cast<uint32_t>(a));
+    STATS_OPERATION(DIV);
+    STATS_DIV(ranks.size(), 1);
+    divide_by_small(mag);
+    sign ^= negative;
+    pull_zero();
+    return *this;
 }
 
-big_integer::big_integer(int a) : big_integer(static_cast<signed long long>(a)) {
+big_integer& big_integer::mod_int(uint64_t mag) {
+    if (mag == 0) {
+        throw std::overflow_error("Zero division");
+    }
+    STATS_OPERATION(DIV);
+    STATS_DIV(ranks.size(), 1);
+    limb_t r = mod_limbs_small(ranks.data(), ranks.size(), mag);
+    ranks.clear();
+    push_el(r);
+    pull_zero();
+    return *this;
 }
 
-big_integer::big_integer(signed long a) : big_integer(static_cast<signed long long>(a)){
+uint32_t big_integer::mod_small(uint32_t x) const {
+    if (x == 0) {
+        throw std::overflow_error("Zero division");
+    }
+    STATS_DIV(ranks.size(), 1);
+    return static_cast<uint32_t>(mod_limbs_small(ranks.data(), ranks.size(), x));
 }
 
-big_integer::big_integer(unsigned long a) : big_integer(static_cast<unsigned long long>(a)){
+big_integer& big_integer::operator*=(big_integer const& rhs) {
+    STATS_OPERATION(MUL);
+    STATS_MUL(ranks.size(), rhs.ranks.size());
+    int64_t x, y, z;
+    if (to_int64(x) && rhs.to_int64(y) && !__builtin_mul_overflow(x, y, &z)) {
+        assign_int64(z);
+        return *this;
+    }
+    big_integer ans;
+    if (is_zero() || rhs.is_zero()) {
+        swap(ans);
+        return *this;
+    }
+    size_t n = ranks.size();
+    size_t m = rhs.ranks.size();
+    ans.ranks.resize(n + m);
+    // x * x is usually a copy multiplied by the original, squaring is cheaper
+    bool same = (n == m && std::equal(ranks.begin(), ranks.end(), rhs.ranks.begin()));
+    mul_limbs(ans.ranks.data(), ranks.data(), n, (same ? ranks.data() : rhs.ranks.data()), m);
+    ans.sign = (sign != rhs.sign);
+    ans.pull_zero();
+    swap(ans);
+    return *this;
 }
 
-// we don't know pb quantity
-big_integer::big_integer(signed long long a): sign(a < 0), ranks({}){
-    unsigned long long x;
-    if (a < 0) {
-        a++;
-        x = static_cast<unsigned long long>(-a) + 1ULL;
-    } else {
-        x = static_cast<unsigned long long>(a);
+big_integer square(big_integer const& a) {
+    STATS_OPERATION(MUL);
+    STATS_MUL(a.ranks.size(), a.ranks.size());
+    big_integer ans;
+    size_t n = a.ranks.size();
+    ans.ranks.resize(2 * n);
+    sqr_limbs(ans.ranks.data(), a.ranks.data(), n);
+    ans.pull_zero();
+    return ans;
+}
+
+void set_multiplication_threads(unsigned threads) {
+    mul_pool.reset(threads > 1 ? new thread_pool(threads - 1) : nullptr);
+}
+
+void set_parallel_threshold(size_t limbs) {
+    parallel_threshold = limbs;
+}
+
+// truncating division like the built-in one: the remainder takes the sign of the dividend
+big_integer& big_integer::div_rem(big_integer const& rhs, big_integer& rem) {
+    if (rhs.is_zero()) {
+        throw std::overflow_error("Zero division");
     }
-    if (x != 0) {
-        ranks.push_back(static_cast<uint32_t>(x));
+    STATS_OPERATION(DIV);
+    STATS_DIV(ranks.size(), rhs.ranks.size());
+    int64_t x, y;
+    if (to_int64(x) && rhs.to_int64(y)) {
+        // x isn't INT64_MIN, so x / -1 doesn't overflow
+        rem.assign_int64(x % y);
+        assign_int64(x / y);
+        return *this;
+    }
+    bool sign_flag = (rhs.sign ^ sign);
+    bool rem_sign = sign;
+    size_t n = ranks.size();
+    size_t m = rhs.ranks.size();
+
+    big_integer q, r;
+    if (n < m) {
+        r.swap(*this);
+    } else if (m == 1) {
+        limb_t d = rhs.ranks[0];
+        q.swap(*this);
+        r = q.divide_by_small(d);
+    } else {
+        q.ranks.resize(n - m + 2);
+        r.ranks.resize(m);
+        divrem_limbs(q.ranks.data(), r.ranks.data(), ranks.data(), n, rhs.ranks.data(), m);
     }
-    x >>= 32;
-    push_el(static_cast<uint32_t>(x));
+    q.sign = sign_flag;
+    q.pull_zero();
+    r.sign = rem_sign;
+    r.pull_zero();
+    swap(q);
+    rem.swap(r);
+    return *this;
 }
 
-big_integer::big_integer(uint32_t a) : big_integer(static_cast<unsigned long long>(a)){
+big_integer pow_mod(big_integer const& base, big_integer const& exp, big_integer const& mod) {
+    STATS_OPERATION(MUL);
+    if (mod.is_zero()) {
+        throw std::overflow_error("Zero division");
+    }
+    if (exp.sign) {
+        throw std::invalid_argument("Negative exponent");
+    }
+    big_integer m(mod);
+    m.sign = false;
+    big_integer g = base % m;
+    if (g.sign) {
+        g += m;
+    }
+    size_t n = m.ranks.size();
+    big_integer res;
+    res.ranks.resize(n);
+    limb_t const* e = exp.ranks.data();
+    if (m.ranks[0] % 2 == 1) {
+        montgomery ctx(m.ranks.data(), n);
+        pow_limbs(res.ranks.data(), g.ranks.data(), g.ranks.size(), e, exp.ranks.size(), ctx);
+    } else {
+        barrett_reducer reducer(m);
+        division_reducer ctx(m.ranks.data(), reducer.normalized.data(),
+                             (reducer.inverse.empty() ? nullptr : reducer.inverse.data()), n);
+        pow_limbs(res.ranks.data(), g.ranks.data(), g.ranks.size(), e, exp.ranks.size(), ctx);
+    }
+    res.pull_zero();
+    return res;
 }
 
-big_integer::big_integer(std::string const& str) : big_integer(){
-    size_t len = str.length();
-    size_t start = ((str[0] == '-') || (str[0] == '+') ? 1 : 0);
-    if (start >= len) {
-        throw std::invalid_argument("Wrong string");
+barrett_reducer::barrett_reducer(big_integer const& m) : mod(m) {
+    if (mod.is_zero()) {
+        throw std::overflow_error("Zero division");
     }
-    for (size_t i = start; i < len; i += 9) {
-        uint32_t degr = 1;
-        uint32_t pul_new = 0;
-        for (size_t j = i; j < std::min(len, i + 9); j++) {
-            if ((str[j] < '0') || (str[j] > '9')) {
-                throw std::invalid_argument("Wrong string");
-            }
-            pul_new *= 10;
-            pul_new += static_cast<uint32_t>(str[j] - '0');
-            degr *= 10;
-        }
-        *this *= degr;
-        *this += pul_new;
+    mod.sign = false;
+    size_t n = mod.ranks.size();
+    normalized.resize(n);
+    shl_limbs(normalized.data(), mod.ranks.data(), n, leading_zeros(mod.ranks[n - 1]));
+    if (n >= BARRETT_THRESHOLD) {
+        inverse.resize(n + 1);
+        reciprocal(inverse.data(), normalized.data(), n);
     }
+}
 
-    sign = static_cast<bool>(start);
-    if (is_zero()) {
-        sign = false;
+// a[0..len] mod |mod|, negated for a negative value
+big_integer barrett_reducer::reduce_limbs(limb_t const* a, size_t len, bool negative) const {
+    size_t n = mod.ranks.size();
+    big_integer res;
+    res.ranks.resize(n);
+    mod_limbs(res.ranks.data(), a, len, mod.ranks.data(), n, (inverse.empty() ? nullptr : inverse.data()),
+              normalized.data());
+    if (negative && !is_zero_limbs(res.ranks.data(), n)) {
+        negate(res.ranks.data(), n);
+        add_to(res.ranks.data(), n, mod.ranks.data(), n);
     }
+    res.pull_zero();
+    return res;
 }
 
-big_integer::~big_integer() = default;
+big_integer barrett_reducer::reduce(big_integer const& a) const {
+    STATS_OPERATION(DIV);
+    STATS_DIV(a.ranks.size(), mod.ranks.size());
+    return reduce_limbs(a.ranks.data(), a.ranks.size(), a.sign);
+}
 
-big_integer& big_integer::operator=(big_integer const& other) = default;
+big_integer barrett_reducer::mulmod(big_integer const& a, big_integer const& b) const {
+    STATS_OPERATION(MUL);
+    STATS_MUL(a.ranks.size(), b.ranks.size());
+    if (a.is_zero() || b.is_zero()) {
+        return big_integer();
+    }
+    scratch_frame frame;
+    size_t len = a.ranks.size() + b.ranks.size();
+    limb_t* t = scratch.take(len);
+    mul_limbs(t, a.ranks.data(), a.ranks.size(), b.ranks.data(), b.ranks.size());
+    return reduce_limbs(t, len, a.sign != b.sign);
+}
 
-big_integer& big_integer::operator+=(big_integer const& rhs) {
-    if (sign != rhs.sign) {
-        if (sign) {
-            sign = false;
-            *this -= rhs;
-            sign = !sign;
-        } else {
-            *this -= -rhs;
+big_integer barrett_reducer::addmod(big_integer const& a, big_integer const& b) const {
+    STATS_OPERATION(ADD);
+    // residues need one subtraction at most
+    if (!a.sign && !b.sign && a < mod && b < mod) {
+        big_integer res = a + b;
+        if (res >= mod) {
+            res -= mod;
         }
-        return *this;
+        return res;
     }
-    size_t n = ranks.size();
-    size_t m = rhs.ranks.size();
-    size_t max_len = std::max(n, m);
-    ranks.resize(max_len);
+    return reduce(a + b);
+}
 
-    uint64_t trans = 0;
-    for (size_t i = 0; i < max_len; i++) {
-        uint64_t t = 0;
-        if (i < m) {
-            t += rhs.ranks[i];
+big_integer gcd(big_integer const& a, big_integer const& b) {
+    STATS_OPERATION(DIV);
+    if (a.ranks.size() <= 1 && b.ranks.size() <= 1) {
+        STATS_TIER(GCD_BINARY);
+        limb_t x = (a.is_zero() ? 0 : a.ranks[0]);
+        limb_t y = (b.is_zero() ? 0 : b.ranks[0]);
+        return big_integer(static_cast<limb_t>(binary_gcd(x, y)));
+    }
+    natural x(a.ranks.begin(), a.ranks.end());
+    natural y(b.ranks.begin(), b.ranks.end());
+    if (compare(x, y) < 0) {
+        x.swap(y);
+    }
+    gcd_naturals(x, y, nullptr);
+    big_integer res;
+    res.ranks.resize(x.size());
+    std::copy(x.begin(), x.end(), res.ranks.begin());
+    return res;
+}
+
+big_integer gcdext(big_integer const& a, big_integer const& b, big_integer& s, big_integer& t) {
+    STATS_OPERATION(DIV);
+    natural x(a.ranks.begin(), a.ranks.end());
+    natural y(b.ranks.begin(), b.ranks.end());
+    int order = compare(x, y);
+    if (order == 0 || b.is_zero()) {
+        big_integer g = (a.sign ? -a : a);
+        s = (order == 0 ? 0 : (a.sign ? -1 : 1));
+        t = (order == 0 ? (b.is_zero() ? 0 : (b.sign ? -1 : 1)) : 0);
+        return g;
+    }
+    if (order < 0) {
+        x.swap(y);
+    }
+    natural c;
+    bool negative;
+    gcd_cofactor(x, y, order < 0, c, negative);
+    big_integer g;
+    g.ranks.resize(x.size());
+    std::copy(x.begin(), x.end(), g.ranks.begin());
+    big_integer u;
+    u.ranks.resize(c.size());
+    std::copy(c.begin(), c.end(), u.ranks.begin());
+    u.sign = (negative != a.sign);
+    u.pull_zero();
+
+    // s is unique modulo |b| / g, the one closest to zero is taken
+    big_integer period = b / g;
+    period.sign = false;
+    if (period == 2) {
+        u = (a.sign ? -1 : 1);
+    } else {
+        u %= period;
+        if (u.sign) {
+            u += period;
         }
-        if (i < n) {
-            t += ranks[i];
+        if (u + u > period) {
+            u -= period;
         }
-        t += trans;
-        trans = t >> 32ul;
-        ranks[i] = static_cast<uint32_t>(t);
     }
-    push_el(static_cast<uint32_t>(trans));
-    pull_zero();
-    return *this;
+    t = (g - a * u) / b;
+    s.swap(u);
+    return g;
 }
 
-big_integer& big_integer::operator-=(big_integer const& rhs) {
-    if (sign != rhs.sign) {
-        sign = !sign;
-        *this += rhs;
-        sign = !sign;
-        return *this;
+big_integer invert(big_integer const& a, big_integer const& m) {
+    STATS_OPERATION(DIV);
+    if (m.is_zero()) {
+        throw std::overflow_error("Zero division");
     }
-    big_integer b(rhs);
-    bool sign_flag = sign;
-    if ((sign && b.sign) ^ (*this < b)) {
-        sign_flag = !sign_flag;
-        sign = false;
-        b.sign = false;
-        swap(b);
+    big_integer mod(m);
+    mod.sign = false;
+    big_integer r = a % mod;
+    if (r.sign) {
+        r += mod;
     }
-    size_t n = ranks.size();
-    size_t m = b.ranks.size();
+    natural x(mod.ranks.begin(), mod.ranks.end());
+    natural y(r.ranks.begin(), r.ranks.end());
+    natural c;
+    bool negative;
+    gcd_cofactor(x, y, true, c, negative);
+    if (x.size() != 1 || x[0] != 1) {
+        throw std::invalid_argument("Not invertible");
+    }
+    big_integer res;
+    res.ranks.resize(c.size());
+    std::copy(c.begin(), c.end(), res.ranks.begin());
+    res %= mod;
+    if (negative && !res.is_zero()) {
+        res = mod - res;
+    }
+    return res;
+}
 
-    uint64_t trans = 0;
-    for (size_t i = 0; i < n; i++) {
-        uint64_t sub = (m > i ? static_cast<uint64_t>(b.ranks[i]) + trans : trans);
-        if (sub > static_cast<uint64_t>(ranks[i])) {
-            sub = base - sub + ranks[i];
-            trans = 1;
-        } else {
-            sub = ranks[i] - sub;
-            trans = 0;
+big_integer iroot(big_integer const& a, unsigned n) {
+    STATS_OPERATION(DIV);
+    if (n == 0) {
+        throw std::invalid_argument("Zero degree");
+    }
+    if (a.sign && n % 2 == 0) {
+        throw std::invalid_argument("Even root of a negative number");
+    }
+    if (a.is_zero() || n == 1) {
+        return a;
+    }
+    natural x(a.ranks.begin(), a.ranks.end());
+    natural r = root_natural(x, bit_length(x), n);
+    big_integer res;
+    res.ranks.resize(r.size());
+    std::copy(r.begin(), r.end(), res.ranks.begin());
+    res.sign = a.sign;
+    return res;
+}
+
+big_integer isqrt(big_integer const& a) {
+    return iroot(a, 2);
+}
+
+bool perfect_power(big_integer const& a) {
+    STATS_OPERATION(DIV);
+    natural x(a.ranks.begin(), a.ranks.end());
+    if (x.empty() || (x.size() == 1 && x[0] == 1)) {
+        return true;
+    }
+    // in a = y^p every prime goes a multiple of p times. the primes below 1000 are divided out,
+    // then p divides the gcd g of their multiplicities
+    size_t g = 0;
+    while (x[g / LIMB_BITS] == 0) {
+        g += LIMB_BITS;
+    }
+    g += __builtin_ctzll(x[g / LIMB_BITS]);
+    x = shifted(x, g);
+    static std::vector<limb_t> const small = [] {
+        std::vector<limb_t> res;
+        for (uint32_t q = 3; q < 1000; q += 2) {
+            if (is_small_prime(q)) {
+                res.push_back(q);
+            }
+        }
+        return res;
+    }();
+    std::vector<limb_t> r(small.size());
+    residues(x, small, r.data());
+    for (size_t i = 0; i < small.size() && g != 1; i++) {
+        if (r[i] == 0) {
+            size_t times = remove_factor(x, small[i]);
+            g = (g == 0 ? times : static_cast<size_t>(binary_gcd(g, times)));
         }
-        ranks[i] = (static_cast<uint32_t>(sub));
     }
-    pull_zero();
-    sign = sign_flag;
-    return *this;
+    // a negative number is an odd power only
+    size_t odd = (g == 0 ? 0 : g >> __builtin_ctzll(g));
+    if (x.size() == 1 && x[0] == 1) {
+        return (a.sign ? odd > 1 : g > 1);
+    }
+    if (g == 1 || (a.sign && odd == 1)) {
+        return false;
+    }
+
+    // the rest has prime divisors from 1009 on, so p < bits / log2(1009). a root of up to 32
+    // bits is the floating point estimate give or take one, it's tried modulo two primes first.
+    // longer ones are found by newton's steps for the p that pass the test of residues
+    size_t bits = bit_length(x);
+    limb_t const m[2] = {4294967291u, 4294967279u};
+    limb_t rm = mod_limbs_small(x.data(), x.size(), m[0] * m[1]);
+    std::vector<unsigned> exps;
+    for (unsigned p = (a.sign ? 3 : 2); p <= bits / 9; p++) {
+        if (!is_small_prime(p) || (g != 0 && g % p != 0)) {
+            continue;
+        }
+        if ((bits - 1) / p + 1 > 32) {
+            exps.push_back(p);
+            continue;
+        }
+        double e = root_estimate(x, p);
+        limb_t last = static_cast<limb_t>(e * (1 + 1e-12)) + 1;
+        for (limb_t y = static_cast<limb_t>(e * (1 - 1e-12)); y <= last; y++) {
+            if (pow_small(y, p, m[0]) == rm % m[0] && pow_small(y, p, m[1]) == rm % m[1] &&
+                compare(power(natural(1, y), p), x) == 0) {
+                return true;
+            }
+        }
+    }
+    for (unsigned p : power_candidates(x, exps)) {
+        if (compare(power(root_natural(x, bits, p), p), x) == 0) {
+            return true;
+        }
+    }
+    return false;
 }
 
-big_integer& big_integer::operator*=(big_integer const& rhs) {
-    big_integer ans;
-    if (is_zero() || rhs.is_zero()) {
-        *this = ans;
-        return *this;
+big_integer pow(big_integer const& base, unsigned exp) {
+    STATS_OPERATION(MUL);
+    if (exp == 0) {
+        return 1;
     }
-    size_t n = ranks.size();
-    size_t m = rhs.ranks.size();
-    ans.ranks.resize(n + m, 0);
-    uint64_t trans = 0;
-    for (size_t i = 0; i < n; i++) {
-        trans = 0;
-        for (size_t j = 0; j < m; j++) {
-            uint64_t x = static_cast<uint64_t>(ranks[i]) * rhs.ranks[j]
-                       + static_cast<uint64_t>(ans.ranks[i + j]) + trans;
-            trans = (x >> 32);
-            ans.ranks[i + j] = static_cast<uint32_t>(x & UINT32_MAX);
+    if (base.is_zero()) {
+        return 0;
+    }
+    // the power of 2 in the base goes into one shift at the end, the squares are shorter
+    size_t zeros = 0;
+    while (base.ranks[zeros / LIMB_BITS] == 0) {
+        zeros += LIMB_BITS;
+    }
+    zeros += __builtin_ctzll(base.ranks[zeros / LIMB_BITS]);
+    big_integer odd = base >> static_cast<int>(zeros);
+    odd.sign = false;
+    // the result has at least this many bits past the first one, they must fit the limbs of a buffer
+    size_t odd_bits = odd.ranks.size() * LIMB_BITS - leading_zeros(odd.ranks.back());
+    if (static_cast<uint128_t>(odd_bits - 1 + zeros) * exp >= static_cast<uint128_t>(UINT32_MAX) * LIMB_BITS) {
+        throw std::length_error("Power too large");
+    }
+    big_integer res = odd;
+    for (int i = 30 - __builtin_clz(exp); i >= 0; i--) {
+        res = square(res);
+        if ((exp >> i) & 1) {
+            res *= odd;
         }
-        ans.ranks[i + m] += static_cast<uint32_t>(trans);
     }
-    ans.sign = (sign != rhs.sign);
-    ans.pull_zero();
-    *this = ans;
-    return *this;
+    // the shift takes int, more than INT_MAX bits go in parts
+    size_t shift = zeros * exp;
+    for (; shift > static_cast<size_t>(std::numeric_limits<int>::max()); shift -= std::numeric_limits<int>::max()) {
+        res <<= std::numeric_limits<int>::max();
+    }
+    res <<= static_cast<int>(shift);
+    if (base.sign && exp % 2 == 1) {
+        res.sign = true;
+    }
+    return res;
 }
 
-big_integer& big_integer::operator/=(big_integer const& rhs) {
-    if (rhs.is_zero()) {
-        throw std::overflow_error("Zero division");
+big_integer factorial(unsigned n) {
+    STATS_OPERATION(MUL);
+    if (n <= 20) {
+        limb_t res = 1;
+        for (unsigned i = 2; i <= n; i++) {
+            res *= i;
+        }
+        return big_integer(static_cast<unsigned long long>(res));
     }
-    bool sign_flag = (rhs.sign ^ sign);
-    big_integer b(rhs);
-    big_integer a(*this);
-    b.sign = false;
-    a.sign = false;
-    size_t n = a.ranks.size();
-    size_t m = b.ranks.size();
-    big_integer ans;
+    // n! = 2^(n - ones in n) and the powers of the odd primes
+    std::vector<limb_t> primes = odd_primes(n);
+    std::vector<limb_t> e(primes.size());
+    for (size_t i = 0; i < primes.size(); i++) {
+        e[i] = factorial_exponent(n, primes[i]);
+    }
+    return prime_power_product(primes, e) << static_cast<int>(n - __builtin_popcount(n));
+}
 
-    if (a < b) {
-        return *this = 0;
+big_integer binomial(unsigned n, unsigned k) {
+    STATS_OPERATION(MUL);
+    if (k > n) {
+        return 0;
     }
-    if (m == 1) {
-        divide_by_small(b.ranks[0]);
-        sign = sign_flag;
-        pull_zero();
-        return *this;
+    k = std::min(k, n - k);
+    if (n <= 67) {
+        // c (n - i) / (i + 1) is the next binomial coefficient, the products stay below 2^70
+        uint128_t c = 1;
+        for (unsigned i = 0; i < k; i++) {
+            c = c * (n - i) / (i + 1);
+        }
+        return big_integer(static_cast<unsigned long long>(c));
     }
-    uint32_t norm = (1ULL << 32) / (b.ranks.back() + 1);
-    a *= norm;
-    b *= norm;
-    a.ranks.push_back(0);
-    n = a.ranks.size();
-    m = b.ranks.size();
-    ans.ranks.resize(n - m);
-
-    for (size_t i = n - m; i > 0; i--) {
-        size_t ind = m + i - 1;
-        uint64_t ans_i = static_cast<uint64_t>(a.ranks[ind]) * base + static_cast<uint64_t>(a.ranks[ind - 1]);
-        ans_i /= static_cast<uint64_t>(b.ranks[m - 1]);
-        uint32_t t = std::min(static_cast<uint32_t>(ans_i), UINT32_MAX);
-
-        big_integer del = b * t;
-        while (t > 0 && compare(a, del, m, i - 1)) {
-            t--;
-            del -= b;
-        }
-
-        uint32_t trans = 0;
-        ans.ranks[i - 1] = t;
-        for (size_t j = 0; j < m; j++) {
-            uint64_t sub = ((del.ranks.size() > j) ? static_cast<uint64_t>(del.ranks[j]) + trans : trans);
-            if (sub > static_cast<uint64_t>(a.ranks[j + i - 1])) {
-                sub = base - sub + a.ranks[j + i - 1];
-                trans = 1;
-            } else {
-                sub = a.ranks[j + i - 1] - sub;
-                trans = 0;
-            }
-            a.ranks[j + i - 1] = (static_cast<uint32_t>(sub));
+    if (k < n / 8) {
+        // n (n - 1) ... (n - k + 1) / k!: the primes up to n would take longer than the division
+        std::vector<limb_t> factors;
+        for (unsigned i = 0; i < k; i++) {
+            factors.push_back(n - i);
         }
+        return product_of_small(factors) / factorial(k);
     }
-    ans.pull_zero();
-    ans.sign = sign_flag;
-    return *this = ans;
+    // the power of p is the number of carries in the sum k + (n - k) in base p, after kummer.
+    // 2 goes into the shift
+    std::vector<limb_t> primes = odd_primes(n);
+    std::vector<limb_t> e(primes.size());
+    for (size_t i = 0; i < primes.size(); i++) {
+        limb_t p = primes[i];
+        e[i] = factorial_exponent(n, p) - factorial_exponent(k, p) - factorial_exponent(n - k, p);
+    }
+    int twos = __builtin_popcount(k) + __builtin_popcount(n - k) - __builtin_popcount(n);
+    return prime_power_product(primes, e) << twos;
+}
+
+big_integer product(std::vector<big_integer> values) {
+    STATS_OPERATION(MUL);
+    if (values.empty()) {
+        return 1;
+    }
+    // neighbours are multiplied in every round, the lengths grow evenly
+    while (values.size() > 1) {
+        size_t half = values.size() / 2;
+        for (size_t i = 0; i < half; i++) {
+            values[i] = std::move(values[2 * i]) * values[2 * i + 1];
+        }
+        if (values.size() % 2 == 1) {
+            values[half] = std::move(values.back());
+            half++;
+        }
+        values.resize(half);
+    }
+    return std::move(values[0]);
+}
+
+std::pair<big_integer, big_integer> divmod(big_integer const& a, big_integer const& b) {
+    std::pair<big_integer, big_integer> res(a, big_integer());
+    res.first.div_rem(b, res.second);
+    return res;
+}
+
+big_integer& big_integer::operator/=(big_integer const& rhs) {
+    big_integer rem;
+    return div_rem(rhs, rem);
 }
 
 big_integer& big_integer::operator%=(big_integer const& rhs) {
-    return *this -= (*this / rhs) * rhs;
+    big_integer rem;
+    div_rem(rhs, rem);
+    swap(rem);
+    return *this;
 }
 
 big_integer& big_integer::operator&=(big_integer const& rhs) {
-    general_bit_operation(rhs,
-                            [](uint32_t x, uint32_t y) {return x & y;});
+    general_bit_operation(rhs, [](limb_t x, limb_t y) { return x & y; });
     return *this;
 }
 
 big_integer& big_integer::operator|=(big_integer const& rhs) {
-    general_bit_operation(rhs,
-                          [](uint32_t x, uint32_t y) {return x | y;});
+    general_bit_operation(rhs, [](limb_t x, limb_t y) { return x | y; });
     return *this;
 }
 
 big_integer& big_integer::operator^=(big_integer const& rhs) {
-    general_bit_operation(rhs,
-                          [](uint32_t x, uint32_t y) {return x ^ y;});
+    general_bit_operation(rhs, [](limb_t x, limb_t y) { return x ^ y; });
     return *this;
 }
 
+// a negative shift goes the other way, its size is taken in size_t so that INT_MIN has one too
+static size_t shift_size(int rhs) {
+    return (rhs < 0 ? 0 - static_cast<size_t>(rhs) : static_cast<size_t>(rhs));
+}
+
 big_integer& big_integer::operator<<=(int rhs) {
-    size_t b32 = rhs / 32;
-    rhs = rhs % 32;
-    std::reverse(ranks.begin(), ranks.end());
-    while ((!ranks.empty()) && (b32 > 0)) {
-        ranks.push_back(0);
-        b32--;
-    }
-    std::reverse(ranks.begin(), ranks.end());
-    uint32_t trans = 0;
-    for (size_t i = 0; i < ranks.size(); i++) {
-        uint64_t x = static_cast<uint64_t>(ranks[i]);
-        x <<= rhs;
-        ranks[i] = x + trans;
-        trans = x >> 32u;
-    }
-    push_el(trans);
-    return *this;
+    STATS_OPERATION(SHIFT);
+    return (rhs < 0 ? shift_right(shift_size(rhs)) : shift_left(shift_size(rhs)));
 }
 
 big_integer& big_integer::operator>>=(int rhs) {
-    size_t b32 = rhs / 32;
-    rhs = rhs % 32;
-    std::reverse(ranks.begin(), ranks.end());
-    while ((!ranks.empty()) && (b32 > 0)) {
-        ranks.pop_back();
-        b32--;
+    STATS_OPERATION(SHIFT);
+    return (rhs < 0 ? shift_left(shift_size(rhs)) : shift_right(shift_size(rhs)));
+}
+
+big_integer& big_integer::shift_left(size_t rhs) {
+    size_t n = ranks.size();
+    if (n == 0) {
+        return *this;
     }
-    std::reverse(ranks.begin(), ranks.end());
+    size_t words = rhs / LIMB_BITS;
+    unsigned bits = rhs % LIMB_BITS;
+    ranks.resize(n + words + 1);
+    limb_t* p = ranks.data();
+    p[n + words] = shl_limbs(p + words, p, n, bits);
+    std::fill(p, p + words, 0);
+    pull_zero();
+    return *this;
+}
 
-    uint32_t trans = 0;
-    for (size_t i = ranks.size(); i > 0; i--) {
-        uint64_t x = static_cast<uint64_t>(ranks[i - 1]);
-        ranks[i - 1] = (x >> rhs) + trans;
-        trans = x << (32u - rhs);
+// rounds down like the arithmetic shift of two's complement: a negative value
+// whose shifted out bits aren't all zero gets one more in magnitude
+big_integer& big_integer::shift_right(size_t rhs) {
+    size_t n = ranks.size();
+    size_t words = rhs / LIMB_BITS;
+    unsigned bits = rhs % LIMB_BITS;
+    if (words >= n) {
+        assign_int64(sign ? -1 : 0);
+        return *this;
     }
-    if (sign) {
-        *this -= 1;
+    limb_t* p = ranks.data();
+    bool round = sign && (!is_zero_limbs(p, words) || (p[words] & ((ONE << bits) - 1)) != 0);
+    shr_limbs(p, p + words, n - words, bits);
+    ranks.resize(n - words);
+    if (round) {
+        push_el(add_to(ranks.data(), n - words, &ONE, 1));
     }
     pull_zero();
     return *this;
@@ -307,16 +3718,20 @@ big_integer big_integer::operator+() const {
     return *this;
 }
 
-big_integer big_integer::operator-() const {
-    if (is_zero()) {
-        return *this;
-    }
+big_integer big_integer::operator-() const& {
     big_integer ans(*this);
-    ans.sign = !ans.sign;
-    return ans;
+    return -std::move(ans);
+}
+
+big_integer big_integer::operator-() && {
+    if (!is_zero()) {
+        sign = !sign;
+    }
+    return std::move(*this);
 }
 
 big_integer big_integer::operator~() const {
+    STATS_OPERATION(BITWISE);
     big_integer ans(*this);
     ans.sign = !ans.sign;
     ans -= 1;
@@ -344,65 +3759,97 @@ big_integer big_integer::operator--(int) {
 }
 
 big_integer operator+(big_integer a, big_integer const& b) {
-    return a += b;
+    a += b;
+    return a;
+}
+
+big_integer operator+(big_integer const& a, big_integer&& b) {
+    b += a;
+    return std::move(b);
 }
 
 big_integer operator-(big_integer a, big_integer const& b) {
-    return a -= b;
+    a -= b;
+    return a;
+}
+
+// a - b = -(b - a), the limbs of b are reused
+big_integer operator-(big_integer const& a, big_integer&& b) {
+    b -= a;
+    return -std::move(b);
 }
 
 big_integer operator*(big_integer a, big_integer const& b) {
-    return a *= b;
+    a *= b;
+    return a;
 }
 
 big_integer operator/(big_integer a, big_integer const& b) {
-   return a /= b;
+    a /= b;
+    return a;
 }
 
 big_integer operator%(big_integer a, big_integer const& b) {
-    return a %= b;
+    a %= b;
+    return a;
 }
 
-void big_integer::general_bit_operation(big_integer const& b,
-                                  const std::function<uint32_t (uint32_t, uint32_t)>& bit_oper) {
-    size_t max_len = std::max(ranks.size(), b.ranks.size());
-    bool sign_flag = static_cast<bool>(
-        bit_oper(static_cast<uint32_t>(sign), static_cast<uint32_t>(b.sign)));
-    big_integer bit_b(b);
-    bitcast(max_len);
-    bit_b.bitcast(max_len);
-    for (size_t i = 0; i < max_len; i++) {
-        ranks[i] = bit_oper(ranks[i], bit_b.ranks[i]);
-    }
-    // if we need to return negative value, we use two's complement
-    if (sign_flag) {
-        for (size_t i = 0; i < ranks.size(); i++) {
-            ranks[i] = ~ranks[i];
-        }
-        *this += 1;
-        sign = true;
+template <typename Op>
+void big_integer::general_bit_operation(big_integer const& rhs, Op op) {
+    STATS_OPERATION(BITWISE);
+    size_t n = ranks.size();
+    size_t m = rhs.ranks.size();
+    bool a_neg = sign;
+    bool b_neg = rhs.sign;
+    // rhs may be *this, its limbs are taken after the resize
+    ranks.resize(std::max(n, m) + 1);
+    limb_t const* b = rhs.ranks.data();
+    if (n >= m) {
+        sign = bitwise_limbs(ranks.data(), ranks.data(), n, a_neg, b, m, b_neg, op);
+    } else {
+        sign = bitwise_limbs(ranks.data(), b, m, b_neg, ranks.data(), n, a_neg, op);
     }
     pull_zero();
 }
 
 big_integer operator&(big_integer a, big_integer const& b) {
-    return a &= b;
+    a &= b;
+    return a;
+}
+
+big_integer operator&(big_integer const& a, big_integer&& b) {
+    b &= a;
+    return std::move(b);
 }
 
 big_integer operator|(big_integer a, big_integer const& b) {
-    return a |= b;
+    a |= b;
+    return a;
+}
+
+big_integer operator|(big_integer const& a, big_integer&& b) {
+    b |= a;
+    return std::move(b);
 }
 
 big_integer operator^(big_integer a, big_integer const& b) {
-    return a ^= b;
+    a ^= b;
+    return a;
+}
+
+big_integer operator^(big_integer const& a, big_integer&& b) {
+    b ^= a;
+    return std::move(b);
 }
 
 big_integer operator<<(big_integer a, int b) {
-    return a <<= b;
+    a <<= b;
+    return a;
 }
 
 big_integer operator>>(big_integer a, int b) {
-    return a >>= b;
+    a >>= b;
+    return a;
 }
 
 bool operator==(big_integer const& a, big_integer const& b){
@@ -425,29 +3872,34 @@ bool operator!=(big_integer const& a, big_integer const& b) {
     return !(a == b);
 }
 
-bool operator<(big_integer const& a, big_integer const& b) {
-    if (a.is_zero() && b.is_zero()) {
-        return false;
-    }
-    size_t n = a.ranks.size();
-    size_t m = b.ranks.size();
-    if (a.sign != b.sign) {
-        return a.sign;
+// the sign of *this - b[0..m] with the sign b_sign
+int big_integer::compare(limb_t const* b, size_t m, bool b_sign) const {
+    size_t n = ranks.size();
+    bool a_neg = (sign && n > 0);
+    bool b_neg = (b_sign && m > 0);
+    if (a_neg != b_neg) {
+        return (a_neg ? -1 : 1);
     }
-    bool ans = true;
-    if (a.sign && b.sign) {
-        ans = !ans;
+    int res = (n != m ? (n < m ? -1 : 1) : compare_limbs(ranks.data(), b, n));
+    return (a_neg ? -res : res);
+}
+
+int big_integer::compare_int(uint64_t mag, bool negative) const {
+    int64_t x;
+    if (mag <= static_cast<uint64_t>(INT64_MAX) && to_int64(x)) {
+        int64_t y = (negative ? -static_cast<int64_t>(mag) : static_cast<int64_t>(mag));
+        return (x > y) - (x < y);
     }
-    if (n == m) {
-        for (size_t i = n; i > 0; i--) {
-            if (a.ranks[i - 1] < b.ranks[i - 1])
-                return ans;
-            if (a.ranks[i - 1] > b.ranks[i - 1])
-                return !ans;
-        }
-        return !ans;
+    limb_t b = mag;
+    return compare(&b, (b != 0 ? 1 : 0), negative);
+}
+
+bool operator<(big_integer const& a, big_integer const& b) {
+    int64_t x, y;
+    if (a.to_int64(x) && b.to_int64(y)) {
+        return x < y;
     }
-    return (n < m ? ans : !ans);
+    return a.compare(b.ranks.data(), b.ranks.size(), b.sign) < 0;
 }
 
 bool operator>(big_integer const& a, big_integer const& b) {
@@ -463,22 +3915,17 @@ bool operator>=(big_integer const& a, big_integer const& b) {
 }
 
 std::string to_string(big_integer const& a) {
-    std::string ans;
+    STATS_OPERATION(TO_STRING);
     if (a.is_zero()) {
         return "0";
     }
-    // need because, we change copy_a, but a is constant
-    big_integer copy_a(a);
-    copy_a.pull_zero();
-
-    while (!copy_a.ranks.empty()){
-        uint32_t x = copy_a.divide_by_small(DI);
-        ans += std::to_string(x);
-    }
-    std::reverse(ans.begin(), ans.end());
-    if (a.sign && !(a.is_zero())) {
-        ans = "-" + ans;
+    std::string ans;
+    // 64 bits give less than twenty digits
+    ans.reserve(a.ranks.size() * 20 + 1);
+    if (a.sign) {
+        ans += '-';
     }
+    to_decimal(ans, a.ranks.data(), a.ranks.size(), 0);
     return ans;
 }
 
@@ -487,7 +3934,7 @@ std::ostream& operator<<(std::ostream& s, big_integer const& a) {
 }
 
 void big_integer::swap(big_integer &other) {
-    std::swap(ranks, other.ranks);
+    ranks.swap(other.ranks);
     std::swap(sign, other.sign);
 }
 
@@ -505,45 +3952,14 @@ void big_integer::pull_zero() {
 }
 
 //stolbik
-uint32_t big_integer::divide_by_small(uint32_t x) {
-    size_t n = ranks.size();
-    uint32_t trans = 0;
-    for (size_t i = n; i > 0; i--) {
-        uint64_t t = static_cast<uint64_t>(ranks[i - 1]) + base * trans;
-        ranks[i - 1] = static_cast<uint32_t>(t / x);
-        trans = static_cast<uint32_t>(t % x);
-    }
+limb_t big_integer::divide_by_small(limb_t x) {
+    limb_t trans = divrem_small(ranks.data(), ranks.size(), x);
     pull_zero();
     return trans;
 }
 
-size_t big_integer::bitcast(size_t need_size) {
-    ranks.resize(need_size);
-    if (sign && !is_zero()) {
-        sign = false;
-        for (size_t i = 0; i < ranks.size(); i++) {
-            ranks[i] = ~ranks[i];
-        }
-        *this += 1;
-    }
-    return ranks.size();
-}
-
-void big_integer::push_el(uint32_t x) {
+void big_integer::push_el(limb_t x) {
     if (x != 0) {
         ranks.push_back(x);
     }
 }
-
-bool big_integer::compare(big_integer &a, big_integer &b, size_t lenb, size_t up) {
-    for (size_t j = lenb; j > 0; j--) {
-        uint32_t t = (j < b.ranks.size() ? b.ranks[j] : 0);
-        if (a.ranks[j + up] < t) {
-            return true;
-        }
-        if (a.ranks[j + up] > t) {
-            return false;
-        }
-    }
-    return false;
-}
\ No newline at end of file
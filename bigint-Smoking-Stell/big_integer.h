@@ -1,15 +1,77 @@
 #pragma once
 
-#include <functional>
+#include <cstddef>
+#include <cstdint>
 #include <iosfwd>
+#include <iterator>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+// a digit of big_integer in base 2^64
+typedef uint64_t limb_t;
+
+// limbs of big_integer: short numbers are kept in place, longer ones go to the heap
+class limb_buffer
+{
+public:
+    limb_buffer() noexcept;
+    limb_buffer(limb_buffer const& other);
+    limb_buffer(limb_buffer&& other) noexcept;
+    ~limb_buffer();
+
+    limb_buffer& operator=(limb_buffer const& other);
+    limb_buffer& operator=(limb_buffer&& other) noexcept;
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    limb_t* data() { return (is_inline() ? small : big); }
+    limb_t const* data() const { return (is_inline() ? small : big); }
+    limb_t* begin() { return data(); }
+    limb_t const* begin() const { return data(); }
+    limb_t* end() { return data() + size_; }
+    limb_t const* end() const { return data() + size_; }
+
+    limb_t& operator[](size_t i) { return data()[i]; }
+    limb_t const& operator[](size_t i) const { return data()[i]; }
+    limb_t& back() { return data()[size_ - 1]; }
+    limb_t const& back() const { return data()[size_ - 1]; }
+
+    // new limbs are zero
+    void resize(size_t n);
+    void push_back(limb_t x);
+    void pop_back() { size_--; }
+    void clear() { size_ = 0; }
+    void swap(limb_buffer& other) noexcept;
+
+private:
+    static const uint32_t INLINE_LIMBS = 2;
+
+    bool is_inline() const { return capacity <= INLINE_LIMBS; }
+    void reallocate(size_t new_capacity);
+
+    uint32_t size_;
+    uint32_t capacity;
+    union
+    {
+        limb_t small[INLINE_LIMBS];
+        limb_t* big;
+    };
+};
+
+// the type of the overloads with built-in integers. wider ones (__int128) would not fit the
+// magnitude of a limb, they are left out rather than cut
+template <typename T, typename R>
+using if_integral = typename std::enable_if<std::is_integral<T>::value && sizeof(T) <= sizeof(long long), R>::type;
+
 struct big_integer
 {
 public:
     big_integer();
     big_integer(big_integer const& other);
+    big_integer(big_integer&& other) noexcept;
     big_integer(int a);
     big_integer(uint32_t a);
     explicit big_integer(std::string const& str);
@@ -21,12 +83,30 @@ public:
     ~big_integer();
 
     big_integer& operator=(big_integer const& other);
+    big_integer& operator=(big_integer&& other) noexcept;
 
     big_integer& operator+=(big_integer const& rhs);
     big_integer& operator-=(big_integer const& rhs);
     big_integer& operator*=(big_integer const& rhs);
     big_integer& operator/=(big_integer const& rhs);
     big_integer& operator%=(big_integer const& rhs);
+    // *this becomes the quotient, rem the remainder
+    big_integer& div_rem(big_integer const& rhs, big_integer& rem);
+
+    // built-in integers are taken as one limb, without a temporary big_integer
+    template <typename T>
+    if_integral<T, big_integer&> operator+=(T rhs) { return add_int(magnitude(rhs), rhs < 0); }
+    template <typename T>
+    if_integral<T, big_integer&> operator-=(T rhs) { return add_int(magnitude(rhs), !(rhs < 0)); }
+    template <typename T>
+    if_integral<T, big_integer&> operator*=(T rhs) { return mul_int(magnitude(rhs), rhs < 0); }
+    template <typename T>
+    if_integral<T, big_integer&> operator/=(T rhs) { return div_int(magnitude(rhs), rhs < 0); }
+    template <typename T>
+    if_integral<T, big_integer&> operator%=(T rhs) { return mod_int(magnitude(rhs)); }
+
+    // |*this| mod x
+    uint32_t mod_small(uint32_t x) const;
 
     big_integer& operator&=(big_integer const& rhs);
     big_integer& operator|=(big_integer const& rhs);
@@ -36,7 +116,8 @@ public:
     big_integer& operator>>=(int rhs);
 
     big_integer operator+() const;
-    big_integer operator-() const;
+    big_integer operator-() const&;
+    big_integer operator-() &&;
     big_integer operator~() const;
 
     big_integer& operator++();
@@ -57,30 +138,71 @@ public:
     friend big_integer operator*(big_integer a, big_integer const& b);
     friend big_integer operator/(big_integer a, big_integer const& b);
     friend big_integer operator%(big_integer a, big_integer const& b);
-
+    // the limbs of an expiring right operand are reused
+    friend big_integer operator+(big_integer const& a, big_integer&& b);
+    friend big_integer operator-(big_integer const& a, big_integer&& b);
 
     friend big_integer operator&(big_integer a, big_integer const& b);
     friend big_integer operator|(big_integer a, big_integer const& b);
     friend big_integer operator^(big_integer a, big_integer const& b);
+    friend big_integer operator&(big_integer const& a, big_integer&& b);
+    friend big_integer operator|(big_integer const& a, big_integer&& b);
+    friend big_integer operator^(big_integer const& a, big_integer&& b);
 
     friend big_integer operator<<(big_integer a, int b);
     friend big_integer operator>>(big_integer a, int b);
 
+    template <typename T>
+    friend if_integral<T, bool> operator==(big_integer const& a, T b);
+    template <typename T>
+    friend if_integral<T, bool> operator!=(big_integer const& a, T b);
+    template <typename T>
+    friend if_integral<T, bool> operator<(big_integer const& a, T b);
+    template <typename T>
+    friend if_integral<T, bool> operator>(big_integer const& a, T b);
+    template <typename T>
+    friend if_integral<T, bool> operator<=(big_integer const& a, T b);
+    template <typename T>
+    friend if_integral<T, bool> operator>=(big_integer const& a, T b);
+
+    friend big_integer square(big_integer const& a);
+    friend big_integer pow_mod(big_integer const& base, big_integer const& exp, big_integer const& mod);
+    friend big_integer gcd(big_integer const& a, big_integer const& b);
+    friend big_integer gcdext(big_integer const& a, big_integer const& b, big_integer& s, big_integer& t);
+    friend big_integer invert(big_integer const& a, big_integer const& m);
+    friend big_integer iroot(big_integer const& a, unsigned n);
+    friend bool perfect_power(big_integer const& a);
+    friend big_integer pow(big_integer const& base, unsigned exp);
+    friend class barrett_reducer;
+
     friend std::string to_string(big_integer const& a);
 
     void swap(big_integer &other);
 
 private:
-    void general_bit_operation(big_integer const& b, const std::function<uint32_t (uint32_t, uint32_t)>&);
+    template <typename T>
+    static uint64_t magnitude(T x) { return (x < 0 ? 0 - static_cast<uint64_t>(x) : static_cast<uint64_t>(x)); }
+
+    big_integer& shift_left(size_t bits);
+    big_integer& shift_right(size_t bits);
+    big_integer& add_int(uint64_t mag, bool negative);
+    big_integer& mul_int(uint64_t mag, bool negative);
+    big_integer& div_int(uint64_t mag, bool negative);
+    big_integer& mod_int(uint64_t mag);
+    int compare_int(uint64_t mag, bool negative) const;
+    int compare(limb_t const* b, size_t m, bool b_sign) const;
+    void add_signed(limb_t const* b, size_t m, bool b_sign);
+    bool to_int64(int64_t& x) const;
+    void assign_int64(int64_t x);
+    template <typename Op>
+    void general_bit_operation(big_integer const& rhs, Op op);
     bool is_zero() const;
-    uint32_t divide_by_small(uint32_t x);
-    size_t bitcast(size_t need_size);
+    limb_t divide_by_small(limb_t x);
     void pull_zero();
-    void push_el(uint32_t x);
+    void push_el(limb_t x);
 
     bool sign;
-    std::vector<uint32_t> ranks;
-    bool compare(big_integer& a, big_integer& b, size_t len, size_t up);
+    limb_buffer ranks;
 };
 
 
@@ -92,5 +214,224 @@ bool operator>(big_integer const& a, big_integer const& b);
 bool operator<=(big_integer const& a, big_integer const& b);
 bool operator>=(big_integer const& a, big_integer const& b);
 
+big_integer square(big_integer const& a);
+// base^exp mod |mod|, in [0, |mod|). exp must not be negative
+big_integer pow_mod(big_integer const& base, big_integer const& exp, big_integer const& mod);
+std::pair<big_integer, big_integer> divmod(big_integer const& a, big_integer const& b);
+// greatest common divisor, not negative
+big_integer gcd(big_integer const& a, big_integer const& b);
+// gcd(a, b) = a s + b t. as in gmp, |s| < |b| / 2g and |t| < |a| / 2g apart from the cases
+// |a| = |b| (s = 0, t = sgn b), b = 0 or |b| = 2g (s = sgn a), a = 0 or |a| = 2g (t = sgn b)
+big_integer gcdext(big_integer const& a, big_integer const& b, big_integer& s, big_integer& t);
+// x in [0, |m|) with a x = 1 modulo m, throws if a and m aren't coprime
+big_integer invert(big_integer const& a, big_integer const& m);
+// the n-th root rounded towards zero, a negative a takes an odd n
+big_integer iroot(big_integer const& a, unsigned n);
+// floor(sqrt(a)) for a >= 0
+big_integer isqrt(big_integer const& a);
+// whether a = x^k for some x and k > 1, as 0, 1 and -1 are
+bool perfect_power(big_integer const& a);
+// base^exp by squarings from the top bit of exp, 0^0 = 1. throws std::length_error for a result
+// too long for the limbs of a buffer
+big_integer pow(big_integer const& base, unsigned exp);
+// n! from the powers of the primes up to n
+big_integer factorial(unsigned n);
+// n! / (k! (n - k)!), zero for k > n
+big_integer binomial(unsigned n, unsigned k);
+// the product of the values by a balanced tree: neighbours are multiplied in rounds, so the long
+// products are of equal lengths. the product of none is one
+big_integer product(std::vector<big_integer> values);
+template <typename Range>
+big_integer product(Range const& values)
+{
+    return product(std::vector<big_integer>(std::begin(values), std::end(values)));
+}
+
+// reduction modulo one modulus shared by many values: |mod| is shifted to its top bit once, and
+// long moduli get their reciprocal once too, then a value of up to twice their length is
+// reduced by two products. results are in [0, |mod|), the products in between live in the
+// scratch space of the calling thread, so one reducer may be used by several threads at once
+class barrett_reducer
+{
+public:
+    explicit barrett_reducer(big_integer const& mod);
+
+    big_integer const& modulus() const { return mod; }
+
+    big_integer reduce(big_integer const& a) const;
+    big_integer mulmod(big_integer const& a, big_integer const& b) const;
+    big_integer addmod(big_integer const& a, big_integer const& b) const;
+
+private:
+    big_integer reduce_limbs(limb_t const* a, size_t len, bool negative) const;
+
+    friend big_integer pow_mod(big_integer const& base, big_integer const& exp, big_integer const& mod);
+
+    big_integer mod;
+    // the modulus shifted to the top bit
+    limb_buffer normalized;
+    // of normalized, empty for moduli that are divided directly
+    limb_buffer inverse;
+};
+
+// products of huge numbers are split between this many threads, the calling one included.
+// 0 and 1 (the default) keep all work on the calling thread. must not be called while
+// big_integers are multiplied or divided
+void set_multiplication_threads(unsigned threads);
+// products whose shorter operand has fewer limbs stay on one thread
+void set_parallel_threshold(size_t limbs);
+
+#ifdef BIG_INTEGER_STATS
+// counters of a build with BIG_INTEGER_STATS defined, summed over all threads
+struct big_integer_stats
+{
+    // limbs are counted for the outermost operation running when they were allocated
+    enum operation { ADD, MUL, DIV, BITWISE, SHIFT, TO_STRING, FROM_STRING, OTHER, OPERATIONS };
+    // every product and square picks a tier, the inner ones of other algorithms too.
+    // a division picks one for every block of the quotient, a gcd one for every step
+    enum tier
+    {
+        MUL_BASECASE, MUL_KARATSUBA, MUL_TOOM32, MUL_TOOM33, MUL_TOOM44, MUL_UNBALANCED, MUL_NTT,
+        SQR_BASECASE, SQR_KARATSUBA, SQR_TOOM3, SQR_TOOM4, SQR_NTT,
+        DIV_SMALL, DIV_SCHOOLBOOK, DIV_RECURSIVE, DIV_BARRETT,
+        GCD_BINARY, GCD_LEHMER, GCD_HALF,
+        TIERS
+    };
+    // bucket k counts lengths of [2^(k - 1), 2^k) limbs, bucket 0 counts zeros
+    static const size_t BUCKETS = 33;
+
+    uint64_t allocations[OPERATIONS];
+    uint64_t allocated_bytes[OPERATIONS];
+    uint64_t tiers[TIERS];
+    // operand lengths of multiplications and divisions, a built-in operand is one limb
+    uint64_t mul_longer[BUCKETS];
+    uint64_t mul_shorter[BUCKETS];
+    uint64_t div_dividend[BUCKETS];
+    uint64_t div_divisor[BUCKETS];
+};
+
+// counts since the start or the last reset_stats
+big_integer_stats get_stats();
+void reset_stats();
+#endif
+
+template <typename T>
+if_integral<T, big_integer> operator+(big_integer a, T b) {
+    a += b;
+    return a;
+}
+
+template <typename T>
+if_integral<T, big_integer> operator+(T a, big_integer b) {
+    b += a;
+    return b;
+}
+
+template <typename T>
+if_integral<T, big_integer> operator-(big_integer a, T b) {
+    a -= b;
+    return a;
+}
+
+template <typename T>
+if_integral<T, big_integer> operator-(T a, big_integer b) {
+    b -= a;
+    return -std::move(b);
+}
+
+template <typename T>
+if_integral<T, big_integer> operator*(big_integer a, T b) {
+    a *= b;
+    return a;
+}
+
+template <typename T>
+if_integral<T, big_integer> operator*(T a, big_integer b) {
+    b *= a;
+    return b;
+}
+
+template <typename T>
+if_integral<T, big_integer> operator/(big_integer a, T b) {
+    a /= b;
+    return a;
+}
+
+template <typename T>
+if_integral<T, big_integer> operator/(T a, big_integer const& b) {
+    return big_integer(a) / b;
+}
+
+template <typename T>
+if_integral<T, big_integer> operator%(big_integer a, T b) {
+    a %= b;
+    return a;
+}
+
+template <typename T>
+if_integral<T, big_integer> operator%(T a, big_integer const& b) {
+    return big_integer(a) % b;
+}
+
+template <typename T>
+if_integral<T, bool> operator==(big_integer const& a, T b) {
+    return a.compare_int(big_integer::magnitude(b), b < 0) == 0;
+}
+
+template <typename T>
+if_integral<T, bool> operator!=(big_integer const& a, T b) {
+    return a.compare_int(big_integer::magnitude(b), b < 0) != 0;
+}
+
+template <typename T>
+if_integral<T, bool> operator<(big_integer const& a, T b) {
+    return a.compare_int(big_integer::magnitude(b), b < 0) < 0;
+}
+
+template <typename T>
+if_integral<T, bool> operator>(big_integer const& a, T b) {
+    return a.compare_int(big_integer::magnitude(b), b < 0) > 0;
+}
+
+template <typename T>
+if_integral<T, bool> operator<=(big_integer const& a, T b) {
+    return a.compare_int(big_integer::magnitude(b), b < 0) <= 0;
+}
+
+template <typename T>
+if_integral<T, bool> operator>=(big_integer const& a, T b) {
+    return a.compare_int(big_integer::magnitude(b), b < 0) >= 0;
+}
+
+template <typename T>
+if_integral<T, bool> operator==(T a, big_integer const& b) {
+    return b == a;
+}
+
+template <typename T>
+if_integral<T, bool> operator!=(T a, big_integer const& b) {
+    return b != a;
+}
+
+template <typename T>
+if_integral<T, bool> operator<(T a, big_integer const& b) {
+    return b > a;
+}
+
+template <typename T>
+if_integral<T, bool> operator>(T a, big_integer const& b) {
+    return b < a;
+}
+
+template <typename T>
+if_integral<T, bool> operator<=(T a, big_integer const& b) {
+    return b >= a;
+}
+
+template <typename T>
+if_integral<T, bool> operator>=(T a, big_integer const& b) {
+    return b <= a;
+}
+
 std::string to_string(big_integer const& a);
 std::ostream& operator<<(std::ostream& s, big_integer const& a);
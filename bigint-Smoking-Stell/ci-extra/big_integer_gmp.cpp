@@ -195,6 +195,81 @@ big_integer_gmp operator>>(big_integer_gmp a, int b)
     return a >>= b;
 }
 
+big_integer_gmp pow_mod(big_integer_gmp const& base, big_integer_gmp const& exp, big_integer_gmp const& mod)
+{
+    big_integer_gmp res;
+    mpz_powm(res.mpz, base.mpz, exp.mpz, mod.mpz);
+    return res;
+}
+
+big_integer_gmp gcd(big_integer_gmp const& a, big_integer_gmp const& b)
+{
+    big_integer_gmp res;
+    mpz_gcd(res.mpz, a.mpz, b.mpz);
+    return res;
+}
+
+big_integer_gmp gcdext(big_integer_gmp const& a, big_integer_gmp const& b, big_integer_gmp& s, big_integer_gmp& t)
+{
+    big_integer_gmp res;
+    mpz_gcdext(res.mpz, s.mpz, t.mpz, a.mpz, b.mpz);
+    return res;
+}
+
+big_integer_gmp invert(big_integer_gmp const& a, big_integer_gmp const& m)
+{
+    big_integer_gmp res;
+    if (mpz_sgn(m.mpz) == 0)
+    {
+        throw std::overflow_error("Zero division");
+    }
+    if (mpz_invert(res.mpz, a.mpz, m.mpz) == 0)
+    {
+        throw std::invalid_argument("Not invertible");
+    }
+    return res;
+}
+
+big_integer_gmp iroot(big_integer_gmp const& a, unsigned n)
+{
+    big_integer_gmp res;
+    mpz_root(res.mpz, a.mpz, n);
+    return res;
+}
+
+big_integer_gmp isqrt(big_integer_gmp const& a)
+{
+    big_integer_gmp res;
+    mpz_sqrt(res.mpz, a.mpz);
+    return res;
+}
+
+bool perfect_power(big_integer_gmp const& a)
+{
+    return mpz_perfect_power_p(a.mpz) != 0;
+}
+
+big_integer_gmp pow(big_integer_gmp const& base, unsigned exp)
+{
+    big_integer_gmp res;
+    mpz_pow_ui(res.mpz, base.mpz, exp);
+    return res;
+}
+
+big_integer_gmp factorial_gmp(unsigned n)
+{
+    big_integer_gmp res;
+    mpz_fac_ui(res.mpz, n);
+    return res;
+}
+
+big_integer_gmp binomial_gmp(unsigned n, unsigned k)
+{
+    big_integer_gmp res;
+    mpz_bin_uiui(res.mpz, n, k);
+    return res;
+}
+
 bool operator==(big_integer_gmp const& a, big_integer_gmp const& b)
 {
     return mpz_cmp(a.mpz, b.mpz) == 0;
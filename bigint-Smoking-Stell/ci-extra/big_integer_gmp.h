@@ -59,6 +59,18 @@ struct big_integer_gmp
     friend bool operator<=(big_integer_gmp const& a, big_integer_gmp const& b);
     friend bool operator>=(big_integer_gmp const& a, big_integer_gmp const& b);
 
+    friend big_integer_gmp pow_mod(big_integer_gmp const& base, big_integer_gmp const& exp,
+                                   big_integer_gmp const& mod);
+    friend big_integer_gmp gcd(big_integer_gmp const& a, big_integer_gmp const& b);
+    friend big_integer_gmp gcdext(big_integer_gmp const& a, big_integer_gmp const& b, big_integer_gmp& s,
+                                  big_integer_gmp& t);
+    friend big_integer_gmp invert(big_integer_gmp const& a, big_integer_gmp const& m);
+    friend big_integer_gmp iroot(big_integer_gmp const& a, unsigned n);
+    friend big_integer_gmp isqrt(big_integer_gmp const& a);
+    friend bool perfect_power(big_integer_gmp const& a);
+    friend big_integer_gmp pow(big_integer_gmp const& base, unsigned exp);
+    friend big_integer_gmp factorial_gmp(unsigned n);
+    friend big_integer_gmp binomial_gmp(unsigned n, unsigned k);
     friend std::string to_string(big_integer_gmp const& a);
 
 private:
@@ -78,6 +90,18 @@ big_integer_gmp operator^(big_integer_gmp a, big_integer_gmp const& b);
 big_integer_gmp operator<<(big_integer_gmp a, int b);
 big_integer_gmp operator>>(big_integer_gmp a, int b);
 
+big_integer_gmp pow_mod(big_integer_gmp const& base, big_integer_gmp const& exp, big_integer_gmp const& mod);
+big_integer_gmp gcd(big_integer_gmp const& a, big_integer_gmp const& b);
+big_integer_gmp gcdext(big_integer_gmp const& a, big_integer_gmp const& b, big_integer_gmp& s, big_integer_gmp& t);
+big_integer_gmp invert(big_integer_gmp const& a, big_integer_gmp const& m);
+big_integer_gmp iroot(big_integer_gmp const& a, unsigned n);
+big_integer_gmp isqrt(big_integer_gmp const& a);
+bool perfect_power(big_integer_gmp const& a);
+big_integer_gmp pow(big_integer_gmp const& base, unsigned exp);
+// the arguments do not name the type, so these are told apart from factorial and binomial by the name
+big_integer_gmp factorial_gmp(unsigned n);
+big_integer_gmp binomial_gmp(unsigned n, unsigned k);
+
 bool operator==(big_integer_gmp const& a, big_integer_gmp const& b);
 bool operator!=(big_integer_gmp const& a, big_integer_gmp const& b);
 bool operator<(big_integer_gmp const& a, big_integer_gmp const& b);
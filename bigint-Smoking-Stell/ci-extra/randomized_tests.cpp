@@ -130,8 +130,35 @@ namespace
 
         return result;
     }
+
+    // blocks of rand_big glued by shifts, so that the length isn't paid for quadratically
+    big_integer rand_long(size_t blocks)
+    {
+        big_integer result = 0;
+        for (size_t i = 0; i != blocks; ++i)
+        {
+            result = (result << 31000) + rand_big(999);
+        }
+        return result;
+    }
 } // namespace
 
+TEST(correctness_random, mul_ntt)
+{
+    // past NTT_THRESHOLD limbs in both operands
+    for (size_t itn = 0; itn != NUMBER_OF_ITERATIONS / 5; ++itn)
+    {
+        big_integer a = rand_long(34);
+        big_integer b = rand_long(32 + rand() % 6);
+        big_integer c = a * b;
+
+        for (int p : {1000000007, 998244353, 2147483647})
+        {
+            EXPECT_EQ(c % p, (a % p) * (b % p) % p);
+        }
+    }
+}
+
 TEST(correctness_random, div_randomized)
 {
     for (size_t itn = 0; itn != NUMBER_OF_ITERATIONS * NUMBER_OF_ITERATIONS;
@@ -207,6 +234,229 @@ TEST(correctness_random, mul)
     }
 }
 
+TEST(correctness_random, mul_large)
+{
+    std::default_random_engine rng(42);
+    for (size_t itn = 0; itn != NUMBER_OF_ITERATIONS; ++itn)
+    {
+        big_integer_gmp a, b;
+        a.random(MAX_SIZE * 4, rng);
+        b.random(MAX_SIZE * 4 - rng() % MAX_SIZE, rng);
+        big_integer_gmp c = a * b;
+        big_integer R = big_integer(to_string(a)) * big_integer(to_string(b));
+        EXPECT_EQ(to_string(c), to_string(R));
+    }
+}
+
+TEST(correctness_random, mul_unbalanced)
+{
+    std::default_random_engine rng(42);
+    for (size_t itn = 0; itn != NUMBER_OF_ITERATIONS; ++itn)
+    {
+        big_integer_gmp a, b;
+        a.random(MAX_SIZE * 8, rng);
+        b.random(MAX_SIZE + rng() % (MAX_SIZE * 2), rng);
+        big_integer_gmp c = a * b;
+        big_integer R = big_integer(to_string(a)) * big_integer(to_string(b));
+        EXPECT_EQ(to_string(c), to_string(R));
+    }
+}
+
+TEST(correctness_random, mul_toom)
+{
+    std::default_random_engine rng(42);
+    for (size_t itn = 0; itn != NUMBER_OF_ITERATIONS / 5; ++itn)
+    {
+        big_integer_gmp a, b, c;
+        a.random(MAX_SIZE * 14, rng);
+        b.random(MAX_SIZE * 14 - rng() % (MAX_SIZE * 2), rng);
+        c.random(MAX_SIZE * 8 + rng() % MAX_SIZE, rng);
+        big_integer A = big_integer(to_string(a));
+        EXPECT_EQ(to_string(a * b), to_string(A * big_integer(to_string(b))));
+        EXPECT_EQ(to_string(a * c), to_string(A * big_integer(to_string(c))));
+    }
+}
+
+TEST(correctness_random, mul_huge)
+{
+    // deep toom-4 and past NTT_THRESHOLD limbs in both operands, unbalanced on top of it
+    std::default_random_engine rng(42);
+    for (size_t itn = 0; itn != NUMBER_OF_ITERATIONS / 10; ++itn)
+    {
+        big_integer_gmp a, b, c;
+        a.random(MAX_SIZE * 200, rng);
+        b.random(MAX_SIZE * 480, rng);
+        c.random(MAX_SIZE * 470 + rng() % (MAX_SIZE * 10), rng);
+        big_integer A = big_integer(to_string(a));
+        big_integer B = big_integer(to_string(b));
+        EXPECT_EQ(to_string(a * a), to_string(A * A));
+        EXPECT_EQ(to_string(b * c), to_string(B * big_integer(to_string(c))));
+        EXPECT_EQ(to_string(a * b), to_string(A * B));
+        EXPECT_EQ(to_string(b * b), to_string(square(B)));
+    }
+}
+
+TEST(correctness_random, square)
+{
+    std::default_random_engine rng(42);
+    for (size_t itn = 0; itn != NUMBER_OF_ITERATIONS; ++itn)
+    {
+        big_integer_gmp a;
+        a.random(rng() % (MAX_SIZE * 8), rng);
+        big_integer A = big_integer(to_string(a));
+        EXPECT_EQ(to_string(a * a), to_string(square(A)));
+        EXPECT_EQ(to_string(a * a), to_string(A * A));
+    }
+}
+
+TEST(correctness_random, pow_mod)
+{
+    std::default_random_engine rng(1729);
+    for (size_t itn = 0; itn != NUMBER_OF_ITERATIONS; ++itn)
+    {
+        big_integer_gmp a, e, m;
+        a.random(MAX_SIZE * 2, rng);
+        e.random(MAX_SIZE, rng);
+        m.random(1 + rng() % MAX_SIZE, rng);
+        if (e < 0)
+        {
+            e = -e;
+        }
+        if (m == 0)
+        {
+            m = 1;
+        }
+        big_integer R = pow_mod(big_integer(to_string(a)), big_integer(to_string(e)), big_integer(to_string(m)));
+        EXPECT_EQ(to_string(pow_mod(a, e, m)), to_string(R));
+    }
+}
+
+TEST(correctness_random, barrett_reducer)
+{
+    std::default_random_engine rng(4096);
+    for (size_t itn = 0; itn != NUMBER_OF_ITERATIONS; ++itn)
+    {
+        // up to 2048 limbs, past the length from which the reciprocal is kept
+        size_t bits = 1 + rng() % (MAX_SIZE * 64);
+        big_integer_gmp a, b, m;
+        m.random(bits, rng);
+        a.random(bits, rng);
+        b.random(bits, rng);
+        if (m == 0)
+        {
+            m = 1;
+        }
+        if (m < 0)
+        {
+            m = -m;
+        }
+        barrett_reducer red(big_integer(to_string(m)));
+        big_integer A = big_integer(to_string(a));
+        big_integer B = big_integer(to_string(b));
+        big_integer_gmp c = (a * b) % m;
+        if (c < 0)
+        {
+            c += m;
+        }
+        EXPECT_EQ(to_string(c), to_string(red.mulmod(A, B)));
+        big_integer_gmp d = (a + b) % m;
+        if (d < 0)
+        {
+            d += m;
+        }
+        EXPECT_EQ(to_string(d), to_string(red.addmod(A, B)));
+    }
+}
+
+TEST(correctness_random, gcd)
+{
+    std::default_random_engine rng(2357);
+    for (size_t itn = 0; itn != NUMBER_OF_ITERATIONS; ++itn)
+    {
+        // a common factor half of the time, so that the gcd isn't almost always small
+        big_integer_gmp a, b, c;
+        a.random(1 + rng() % (MAX_SIZE * 32), rng);
+        b.random(1 + rng() % (MAX_SIZE * 32), rng);
+        if (rng() % 2 == 0)
+        {
+            c.random(1 + rng() % (MAX_SIZE * 32), rng);
+            a *= c;
+            b *= c;
+        }
+        big_integer A = big_integer(to_string(a));
+        big_integer B = big_integer(to_string(b));
+        EXPECT_EQ(to_string(gcd(a, b)), to_string(gcd(A, B)));
+        big_integer_gmp s, t;
+        big_integer S, T;
+        EXPECT_EQ(to_string(gcdext(a, b, s, t)), to_string(gcdext(A, B, S, T)));
+        EXPECT_EQ(to_string(s), to_string(S));
+        EXPECT_EQ(to_string(t), to_string(T));
+        if (b != 0 && gcd(a, b) == 1)
+        {
+            EXPECT_EQ(to_string(invert(a, b)), to_string(invert(A, B)));
+        }
+    }
+}
+
+TEST(correctness_random, roots)
+{
+    std::default_random_engine rng(1618);
+    for (size_t itn = 0; itn != NUMBER_OF_ITERATIONS; ++itn)
+    {
+        big_integer_gmp a;
+        a.random(1 + rng() % (MAX_SIZE * 64), rng);
+        unsigned n = 1 + rng() % (itn % 2 == 0 ? 5 : 200);
+        if (a < 0)
+        {
+            a = -a;
+        }
+        big_integer A = big_integer(to_string(a));
+        EXPECT_EQ(to_string(isqrt(a)), to_string(isqrt(A)));
+        EXPECT_EQ(to_string(iroot(a, n)), to_string(iroot(A, n)));
+        EXPECT_EQ(perfect_power(a), perfect_power(A));
+
+        // a power of the root, on both sides of zero for an odd degree
+        big_integer_gmp r = iroot(a, n);
+        big_integer_gmp p = 1;
+        for (unsigned i = 0; i < n; i++)
+        {
+            p *= r;
+        }
+        if (n % 2 == 1 && rng() % 2 == 0)
+        {
+            p = -p;
+        }
+        big_integer P = big_integer(to_string(p));
+        EXPECT_EQ(to_string(iroot(p, n)), to_string(iroot(P, n)));
+        EXPECT_EQ(perfect_power(p), perfect_power(P));
+        EXPECT_EQ(perfect_power(p + 1), perfect_power(P + 1));
+    }
+}
+
+TEST(correctness_random, pow)
+{
+    std::default_random_engine rng(2718);
+    for (size_t itn = 0; itn != NUMBER_OF_ITERATIONS; ++itn)
+    {
+        big_integer_gmp a;
+        a.random(1 + rng() % 256, rng);
+        // a multiple of a power of 2 now and then, for the shift at the end
+        if (itn % 3 == 0)
+        {
+            a = a << static_cast<int>(rng() % 200);
+        }
+        unsigned exp = rng() % (MAX_SIZE * 64 / 256);
+        big_integer A = big_integer(to_string(a));
+        EXPECT_EQ(to_string(pow(a, exp)), to_string(pow(A, exp)));
+
+        unsigned n = rng() % 20000;
+        unsigned k = rng() % (n + 2);
+        EXPECT_EQ(to_string(factorial_gmp(n)), to_string(factorial(n)));
+        EXPECT_EQ(to_string(binomial_gmp(n, k)), to_string(binomial(n, k)));
+        EXPECT_EQ(to_string(binomial_gmp(n, k / 16)), to_string(binomial(n, k / 16)));
+    }
+}
+
 TEST(correctness_random, div)
 {
     std::default_random_engine rng(322);
@@ -225,6 +475,43 @@ TEST(correctness_random, div)
     }
 }
 
+TEST(correctness_random, div_large)
+{
+    std::default_random_engine rng(322);
+    for (size_t itn = 0; itn != NUMBER_OF_ITERATIONS; ++itn)
+    {
+        big_integer_gmp a, b;
+        a.random(MAX_SIZE * 8, rng);
+        b.random(MAX_SIZE + rng() % (MAX_SIZE * 6), rng);
+        big_integer A = big_integer(to_string(a));
+        big_integer B = big_integer(to_string(b));
+        EXPECT_EQ(to_string(a / b), to_string(A / B));
+        EXPECT_EQ(to_string(a % b), to_string(A % B));
+    }
+}
+
+TEST(correctness_random, div_huge)
+{
+    // divisors deep in burnikel-ziegler recursion and past the newton reciprocal, quotients from
+    // a limb to twice their length
+    std::default_random_engine rng(322);
+    for (size_t itn = 0; itn != NUMBER_OF_ITERATIONS / 2; ++itn)
+    {
+        size_t bits = MAX_SIZE * (itn % 2 == 0 ? 64 : 160);
+        big_integer_gmp b;
+        b.random(bits, rng);
+        big_integer B = big_integer(to_string(b));
+        for (size_t extra : {size_t(64), bits / 20 + rng() % bits, bits + rng() % bits})
+        {
+            big_integer_gmp a;
+            a.random(bits + extra, rng);
+            big_integer A = big_integer(to_string(a));
+            EXPECT_EQ(to_string(a / b), to_string(A / B));
+            EXPECT_EQ(to_string(a % b), to_string(A % B));
+        }
+    }
+}
+
 TEST(correctness_random, mod)
 {
     std::default_random_engine rng(322);
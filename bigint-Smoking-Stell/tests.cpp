@@ -1,8 +1,14 @@
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstdlib>
+#include <new>
 #include <string>
 #include <limits>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #include <gtest/gtest.h>
 
 #include "big_integer.h"
@@ -286,6 +292,42 @@ TEST(correctness, div_return_value)
     EXPECT_EQ(25, a);
 }
 
+TEST(correctness, divmod)
+{
+    big_integer a("-100000000000000000000000000000000000000000000000000000000000023");
+    big_integer b("10000000000000000000000000000005");
+    std::pair<big_integer, big_integer> qr = divmod(a, b);
+
+    EXPECT_EQ(a / b, qr.first);
+    EXPECT_EQ(a % b, qr.second);
+    EXPECT_EQ(a, qr.first * b + qr.second);
+    EXPECT_TRUE(qr.second < 0);
+
+    qr = divmod(big_integer(-23), big_integer(5));
+    EXPECT_EQ(-4, qr.first);
+    EXPECT_EQ(-3, qr.second);
+
+    qr = divmod(big_integer(5), big_integer(-23));
+    EXPECT_EQ(0, qr.first);
+    EXPECT_EQ(5, qr.second);
+}
+
+TEST(correctness, div_rem)
+{
+    big_integer a = 23;
+    big_integer r;
+
+    a.div_rem(-5, r);
+    EXPECT_EQ(-4, a);
+    EXPECT_EQ(3, r);
+
+    a.div_rem(a, r);
+    EXPECT_EQ(1, a);
+    EXPECT_EQ(0, r);
+
+    EXPECT_THROW(a.div_rem(0, r), std::overflow_error);
+}
+
 TEST(correctness, unary_plus)
 {
     big_integer a = 123;
@@ -440,6 +482,21 @@ TEST(correctness, xor_return_value)
     EXPECT_EQ(2, a);
 }
 
+TEST(correctness, bitwise_signed_long)
+{
+    // the low zero limbs of negative values carry the +1 of two's complement
+    big_integer a = -(big_integer(1) << 96);
+    big_integer b = -((big_integer(1) << 64) + 5) * (big_integer(1) << 32) + 7;
+
+    EXPECT_EQ(big_integer("-158456325028528675187087900672"), a & b);
+    EXPECT_EQ(big_integer("-21474836473"), a | b);
+    EXPECT_EQ(big_integer("158456325028528675165613064199"), a ^ b);
+    // the result is one limb longer than both operands
+    EXPECT_EQ(-(big_integer(1) << 32), big_integer(-2) & big_integer(-4294967295LL));
+    EXPECT_EQ(a, a & a);
+    EXPECT_EQ(0, a ^ a);
+}
+
 TEST(correctness, not_)
 {
     big_integer a = 0xaa;
@@ -499,6 +556,35 @@ TEST(correctness, shr_signed)
     EXPECT_EQ(-155, a);
 }
 
+TEST(correctness, shr_signed_exact)
+{
+    // nothing is shifted out, so there's nothing to round
+    big_integer a = -(big_integer(5) << 100);
+
+    EXPECT_EQ(-5, a >> 100);
+    EXPECT_EQ(-3, a >> 101);
+    EXPECT_EQ(-(big_integer(5) << 36), a >> 64);
+    EXPECT_EQ(-1, a >> 1000);
+    EXPECT_EQ(-1, big_integer(-1) >> 1);
+    EXPECT_EQ(-8, big_integer(-16) >> 1);
+}
+
+TEST(correctness, shift_negative)
+{
+    // a negative shift goes the other way, INT_MIN included
+    int min = std::numeric_limits<int>::min();
+    big_integer a = big_integer(-12345) << 100;
+
+    EXPECT_EQ(big_integer(-12345) << 102, a >> -2);
+    EXPECT_EQ(-3087, a << -102);
+    EXPECT_EQ(0, big_integer(12345) << min);
+    EXPECT_EQ(-1, a << min);
+    EXPECT_EQ(0, big_integer(0) >> min);
+
+    a <<= min;
+    EXPECT_EQ(-1, a);
+}
+
 TEST(correctness, shr_return_value)
 {
     big_integer a = 64;
@@ -600,6 +686,386 @@ TEST(correctness, mul_long_pow2)
     EXPECT_EQ(c, b * b);
 }
 
+TEST(correctness, mul_long_basecase)
+{
+    for (int i = 1; i < 70; i += 3)
+    {
+        for (int j = 1; j <= i; j += 5)
+        {
+            big_integer a = (big_integer(1) << (32 * i)) - 1;
+            big_integer b = (big_integer(1) << (32 * j + 16)) - 1;
+
+            EXPECT_EQ((big_integer(1) << (64 * i)) - (big_integer(1) << (32 * i + 1)) + 1, a * a);
+            EXPECT_EQ((big_integer(1) << (32 * (i + j) + 16)) - (big_integer(1) << (32 * i))
+                      - (big_integer(1) << (32 * j + 16)) + 1, a * b);
+        }
+    }
+}
+
+TEST(correctness, mul_long_karatsuba)
+{
+    big_integer a = (big_integer(1) << 10000) - 1;
+    big_integer b = (big_integer(1) << 3000) - 1;
+
+    EXPECT_EQ((big_integer(1) << 20000) - (big_integer(1) << 10001) + 1, a * a);
+    EXPECT_EQ((big_integer(1) << 13000) - (big_integer(1) << 10000) - (big_integer(1) << 3000) + 1, a * b);
+    EXPECT_EQ(a * b, b * a);
+}
+
+TEST(correctness, mul_long_toom)
+{
+    big_integer a = (big_integer(1) << 50000) - 1;
+    big_integer b = (big_integer(1) << 32000) - 1;
+    big_integer c = (big_integer(1) << 20000) + 1;
+
+    EXPECT_EQ((big_integer(1) << 100000) - (big_integer(1) << 50001) + 1, a * a);
+    EXPECT_EQ((big_integer(1) << 82000) - (big_integer(1) << 50000) - (big_integer(1) << 32000) + 1, a * b);
+    EXPECT_EQ((big_integer(1) << 52000) + (big_integer(1) << 32000) - (big_integer(1) << 20000) - 1, b * c);
+}
+
+TEST(correctness, mul_long_ntt)
+{
+    // both past NTT_THRESHOLD limbs
+    big_integer a = (big_integer(1) << 1200000) - 1;
+    big_integer b = (big_integer(1) << 1000000) - 1;
+
+    EXPECT_EQ((big_integer(1) << 2400000) - (big_integer(1) << 1200001) + 1, a * a);
+    EXPECT_EQ((big_integer(1) << 2200000) - (big_integer(1) << 1200000) - (big_integer(1) << 1000000) + 1, a * b);
+}
+
+TEST(correctness, mul_long_parallel)
+{
+    big_integer a = ((big_integer(1) << 128000) - 1) / 7 * 5 + 12345;
+    big_integer b = ((big_integer(1) << 20000) - 1) / 3;
+    big_integer c = ((big_integer(1) << 960000) - 1) / 7 * 5 + 12345;
+    big_integer aa = a * a;
+    big_integer ab = a * b;
+    big_integer bc = b * c;
+
+    set_multiplication_threads(4);
+    set_parallel_threshold(50);
+    EXPECT_EQ(aa, square(a));
+    EXPECT_EQ(ab, a * b);
+    EXPECT_EQ(bc, b * c);
+    EXPECT_EQ(square(c) + c, c * (c + 1));
+    set_multiplication_threads(1);
+}
+
+TEST(correctness, square)
+{
+    big_integer a("-100000000000000000000000000");
+    big_integer c( "100000000000000000000000000"
+                    "00000000000000000000000000");
+
+    EXPECT_EQ(c, square(a));
+    EXPECT_EQ(0, square(big_integer()));
+    EXPECT_EQ(1, square(big_integer(-1)));
+
+    for (int bits : {1000, 10000, 100000})
+    {
+        big_integer x = (big_integer(1) << bits) - 1;
+        big_integer y = x;
+        y *= y;
+        EXPECT_EQ((big_integer(1) << (2 * bits)) - (big_integer(1) << (bits + 1)) + 1, square(x));
+        EXPECT_EQ(square(x), y);
+    }
+}
+
+TEST(correctness, pow_mod)
+{
+    EXPECT_EQ(24, pow_mod(2, 10, 1000));
+    EXPECT_EQ(445, pow_mod(4, 13, 497));
+    EXPECT_EQ(1, pow_mod(12345, 0, 7));
+    EXPECT_EQ(0, pow_mod(12345, 0, 1));
+    EXPECT_EQ(0, pow_mod(0, 5, 7));
+    EXPECT_EQ(4, pow_mod(-2, 3, 12));
+    EXPECT_EQ(4, pow_mod(-2, 3, -12));
+    EXPECT_EQ(6, pow_mod(-1, 3, 7));
+    EXPECT_THROW(pow_mod(2, 3, 0), std::overflow_error);
+    EXPECT_THROW(pow_mod(2, -3, 7), std::invalid_argument);
+
+    // fermat's little theorem for mersenne primes of 2, 9 and 20 limbs
+    for (int p : {127, 521, 1279})
+    {
+        big_integer m = (big_integer(1) << p) - 1;
+        EXPECT_EQ(1, pow_mod(3, m - 1, m));
+        EXPECT_EQ(m - 3, pow_mod(-3, m, m));
+    }
+
+    // odd and even moduli against repeated multiplication, up to the product-based reduction
+    for (int bits : {200, 3000, 64000})
+    {
+        big_integer x = (big_integer(1) << (bits + 100)) / 7;
+        for (big_integer m : {(big_integer(1) << bits) - 1, (big_integer(1) << bits) - 2})
+        {
+            big_integer r = 1;
+            for (int i = 0; i < 5; i++)
+            {
+                r = r * x % m;
+            }
+            EXPECT_EQ(r, pow_mod(x, 5, m));
+        }
+    }
+}
+
+TEST(correctness, barrett_reducer)
+{
+    barrett_reducer r(-7);
+    EXPECT_EQ(7, r.modulus());
+    EXPECT_EQ(3, r.reduce(10));
+    EXPECT_EQ(4, r.reduce(-10));
+    EXPECT_EQ(0, r.reduce(-14));
+    EXPECT_EQ(1, r.mulmod(3, 5));
+    EXPECT_EQ(6, r.mulmod(-3, 5));
+    EXPECT_EQ(0, r.mulmod(0, 5));
+    EXPECT_EQ(1, r.addmod(3, 5));
+    EXPECT_EQ(6, r.addmod(3, 3));
+    EXPECT_EQ(5, r.addmod(-3, 1));
+    EXPECT_THROW(barrett_reducer(0), std::overflow_error);
+
+    // short moduli are divided directly, long ones go through the reciprocal
+    for (int bits : {3000, 100000})
+    {
+        big_integer m = (big_integer(1) << bits) - 1;
+        barrett_reducer red(m);
+        big_integer x = (big_integer(1) << (bits - 1)) / 3;
+        big_integer y = m - 5;
+        EXPECT_EQ(x * y % m, red.mulmod(x, y));
+        EXPECT_EQ(m - x * y % m, red.mulmod(-x, y));
+        EXPECT_EQ(x - 5, red.addmod(x, y));
+        EXPECT_EQ(1, red.reduce(big_integer(1) << (3 * bits)));
+        EXPECT_EQ(m - 1, red.reduce(-(big_integer(1) << (3 * bits))));
+    }
+}
+
+TEST(correctness, gcd)
+{
+    EXPECT_EQ(6, gcd(12, 18));
+    EXPECT_EQ(6, gcd(-12, 18));
+    EXPECT_EQ(6, gcd(12, -18));
+    EXPECT_EQ(5, gcd(0, -5));
+    EXPECT_EQ(0, gcd(0, 0));
+    EXPECT_EQ(1, gcd(17, 5));
+
+    big_integer s, t;
+    EXPECT_EQ(2, gcdext(240, 46, s, t));
+    EXPECT_EQ(-9, s);
+    EXPECT_EQ(47, t);
+    EXPECT_EQ(5, gcdext(0, -5, s, t));
+    EXPECT_EQ(0, s);
+    EXPECT_EQ(-1, t);
+    EXPECT_EQ(7, gcdext(-7, 7, s, t));
+    EXPECT_EQ(0, s);
+    EXPECT_EQ(1, t);
+
+    EXPECT_EQ(4, invert(3, 11));
+    EXPECT_EQ(7, invert(-3, 11));
+    EXPECT_EQ(4, invert(3, -11));
+    EXPECT_EQ(0, invert(5, 1));
+    EXPECT_THROW(invert(4, 10), std::invalid_argument);
+    EXPECT_THROW(invert(3, 0), std::overflow_error);
+
+    // fibonacci numbers are the longest way for euclid, a common factor of 2^k + 1 goes along,
+    // from lehmer's steps up to the half-gcd
+    for (int n : {300, 3000, 30000})
+    {
+        big_integer f0 = 0, f1 = 1;
+        for (int i = 0; i < n; i++)
+        {
+            big_integer f2 = f0 + f1;
+            f0 = f1;
+            f1 = f2;
+        }
+        big_integer c = (big_integer(1) << (n / 2)) + 1;
+        EXPECT_EQ(c, gcd(f1 * c, f0 * c));
+        EXPECT_EQ(c, gcdext(f1 * c, f0 * c, s, t));
+        EXPECT_EQ(c, f1 * c * s + f0 * c * t);
+        big_integer x = invert(f0, f1);
+        EXPECT_EQ(1, x * f0 % f1);
+        EXPECT_TRUE(0 <= x && x < f1);
+    }
+
+    // small quotients with a huge one among them: the half-gcd meets b shorter than the part of
+    // a it would reduce
+    for (int huge : {3000, 20000})
+    {
+        for (int before : {0, 500, 2000})
+        {
+            big_integer a = 1, b = 0;
+            for (int i = 3000 + before; i >= 0; i--)
+            {
+                big_integer q = (i == before ? (big_integer(1) << huge) + 3 : big_integer(1 + i % 7));
+                big_integer c = q * a + b;
+                b = a;
+                a = c;
+            }
+            big_integer c = (big_integer(1) << 200) + 1;
+            EXPECT_EQ(1, gcd(a, b));
+            EXPECT_EQ(c, gcdext(a * c, b * c, s, t));
+            EXPECT_EQ(c, a * c * s + b * c * t);
+            big_integer x = invert(b, a);
+            EXPECT_EQ(1, x * b % a);
+            EXPECT_THROW(invert(b * c, a * c), std::invalid_argument);
+        }
+    }
+}
+
+TEST(correctness, roots)
+{
+    EXPECT_EQ(0, isqrt(0));
+    EXPECT_EQ(1, isqrt(3));
+    EXPECT_EQ(3, isqrt(15));
+    EXPECT_EQ(4, isqrt(16));
+    EXPECT_EQ(4294967295u, isqrt(big_integer("18446744073709551615")));
+    EXPECT_EQ(big_integer("100000000000000000000"), isqrt(big_integer("10000000000000000000000000000000000000000")));
+    EXPECT_EQ(big_integer("99999999999999999999"), isqrt(big_integer("9999999999999999999999999999999999999999")));
+    EXPECT_EQ(2, iroot(26, 3));
+    EXPECT_EQ(3, iroot(27, 3));
+    EXPECT_EQ(-3, iroot(-28, 3));
+    EXPECT_EQ(-5, iroot(-5, 1));
+    EXPECT_EQ(2, iroot(big_integer(1) << 100, 100));
+    EXPECT_EQ(1, iroot((big_integer(1) << 100) - 1, 100));
+    EXPECT_EQ(-1, iroot(-(big_integer(1) << 100), 4000000001u));
+    EXPECT_THROW(isqrt(-1), std::invalid_argument);
+    EXPECT_THROW(iroot(-16, 4), std::invalid_argument);
+    EXPECT_THROW(iroot(5, 0), std::invalid_argument);
+
+    // exact powers and their neighbours, from the floating point estimate up to a few newton levels
+    for (int bits : {50, 1000, 20000})
+    {
+        big_integer x = (big_integer(1) << bits) / 3;
+        for (unsigned n : {2u, 3u, 7u})
+        {
+            big_integer p = 1;
+            for (unsigned i = 0; i < n; i++)
+            {
+                p *= x;
+            }
+            EXPECT_EQ(x, iroot(p, n));
+            EXPECT_EQ(x - 1, iroot(p - 1, n));
+            EXPECT_EQ(x, iroot(p + 1, n));
+        }
+        EXPECT_EQ(x, isqrt(x * x + 2 * x));
+    }
+}
+
+TEST(correctness, perfect_power)
+{
+    for (int x : {0, 1, -1, 4, 8, -8, 27, 1024, -32768, 248832})
+    {
+        EXPECT_TRUE(perfect_power(x));
+    }
+    for (int x : {2, 3, -4, -16, 6, 12, 2147483647, 10 * 10 * 10 * 3})
+    {
+        EXPECT_FALSE(perfect_power(x));
+    }
+
+    // a root beyond the primes that are divided out, powers of 2 and of a product with small primes
+    big_integer y("1000000000000000000000000000057");
+    EXPECT_TRUE(perfect_power(y * y));
+    EXPECT_TRUE(perfect_power(-(y * y * y)));
+    EXPECT_FALSE(perfect_power(-(y * y)));
+    EXPECT_FALSE(perfect_power(y * y + 1));
+    EXPECT_FALSE(perfect_power(y * y * y * 7));
+    EXPECT_TRUE(perfect_power(big_integer(1) << 1000));
+    EXPECT_TRUE(perfect_power(big_integer(1) << 1009));
+    EXPECT_FALSE(perfect_power(-(big_integer(1) << 1024)));
+    EXPECT_TRUE(perfect_power(-(big_integer(1) << 1009)));
+    big_integer z = y * 6;
+    big_integer p = 1;
+    for (int i = 0; i < 31; i++)
+    {
+        p *= z;
+    }
+    EXPECT_TRUE(perfect_power(p));
+    EXPECT_FALSE(perfect_power(p * 5));
+    EXPECT_FALSE(perfect_power(p - 1));
+}
+
+TEST(correctness, pow)
+{
+    EXPECT_EQ(pow(big_integer(2), 10), 1024);
+    EXPECT_EQ(pow(big_integer(-3), 3), -27);
+    EXPECT_EQ(pow(big_integer(-3), 4), 81);
+    EXPECT_EQ(pow(big_integer(0), 0), 1);
+    EXPECT_EQ(pow(big_integer(0), 5), 0);
+    EXPECT_EQ(pow(big_integer(-1), 1000001), -1);
+    EXPECT_EQ(pow(big_integer(12), 1), 12);
+    EXPECT_EQ(pow(big_integer(1) << 100, 7), big_integer(1) << 700);
+    EXPECT_EQ(pow(-(big_integer(3) << 70), 3), -(big_integer(27) << 210));
+
+    big_integer a("123456789012345678901234567890");
+    big_integer p = 1;
+    for (int i = 0; i < 37; i++)
+    {
+        p *= a;
+    }
+    EXPECT_EQ(pow(a, 37), p);
+    EXPECT_EQ(pow(-a, 37), -p);
+
+    // too long results are told before anything is multiplied, powers of 2 in the base included
+    EXPECT_EQ(pow(big_integer(-1), std::numeric_limits<unsigned>::max()), -1);
+    EXPECT_THROW(pow(big_integer(1) << 200, 1u << 31), std::length_error);
+    EXPECT_THROW(pow(a << 1000, 1u << 30), std::length_error);
+    EXPECT_THROW(pow(a, std::numeric_limits<unsigned>::max()), std::length_error);
+}
+
+TEST(correctness, factorial_binomial)
+{
+    unsigned long long f = 1;
+    for (unsigned n = 0; n <= 20; n++)
+    {
+        f *= (n == 0 ? 1 : n);
+        EXPECT_EQ(factorial(n), f);
+    }
+    EXPECT_EQ(factorial(25), big_integer("15511210043330985984000000"));
+
+    // n! from the products of 1..n and binomials from the quotients of factorials, past every
+    // branch of both
+    big_integer p = 1;
+    for (unsigned n = 1; n <= 300; n++)
+    {
+        p *= n;
+        EXPECT_EQ(factorial(n), p);
+    }
+    EXPECT_EQ(binomial(5, 2), 10);
+    EXPECT_EQ(binomial(5, 6), 0);
+    EXPECT_EQ(binomial(0, 0), 1);
+    EXPECT_EQ(binomial(67, 33), big_integer("14226520737620288370"));
+    for (unsigned n : {68u, 100u, 257u, 1000u})
+    {
+        for (unsigned k : {0u, 1u, 2u, 7u, n / 8, n / 3, n / 2, n - 1, n})
+        {
+            EXPECT_EQ(binomial(n, k), factorial(n) / factorial(k) / factorial(n - k));
+        }
+    }
+    big_integer row = 1;
+    for (unsigned k = 0; k <= 3000; k++)
+    {
+        EXPECT_EQ(binomial(3000, k), row);
+        row = row * (3000 - k) / (k + 1);
+    }
+}
+
+TEST(correctness, product)
+{
+    EXPECT_EQ(product(std::vector<big_integer>()), 1);
+    int one[] = {-7};
+    EXPECT_EQ(product(one), -7);
+    int small[] = {2, -3, 5, 7, -11};
+    EXPECT_EQ(product(small), 2310);
+
+    std::vector<big_integer> values;
+    big_integer p = 1;
+    for (int i = 1; i <= 1001; i++)
+    {
+        values.push_back((big_integer(i) << (i % 300)) - 1);
+        p *= values.back();
+    }
+    EXPECT_EQ(product(values), p);
+    values.push_back(0);
+    EXPECT_EQ(product(values), 0);
+}
 
 TEST(correctness, div_long)
 {
@@ -628,6 +1094,49 @@ TEST(correctness, div_long_signed2)
     EXPECT_EQ(c, a / b);
 }
 
+TEST(correctness, div_long_add_back)
+{
+    // the quotient limb estimated by the top three limbs is still one too big here
+    big_integer a("730750819346016192904105262046205299964145303552");
+    big_integer b("170141183618925556750992606870412197889");
+    EXPECT_EQ(big_integer("4294967295"), a / b);
+    EXPECT_EQ(big_integer("170141183618925556750992606861822263297"), a % b);
+
+    big_integer c("730750818835592642601925729337737610305915060225");
+    big_integer d("79228162532711081673990313665");
+    EXPECT_EQ(big_integer("9223372036854775807"), c / d);
+    EXPECT_EQ(big_integer("56706123009379957092731557570"), c % d);
+}
+
+TEST(correctness, div_long_recursive)
+{
+    // long enough for burnikel-ziegler recursion
+    big_integer a = (big_integer(1) << 70000) - 1;
+    big_integer b = (big_integer(1) << 150000) + 12345;
+    big_integer c = b * a * a + a - 1;
+
+    EXPECT_EQ(b * a, c / a);
+    EXPECT_EQ(a - 1, c % a);
+    EXPECT_EQ(a * a, c / b);
+    EXPECT_EQ(a - 1, c % b);
+}
+
+TEST(correctness, div_short_quotient)
+{
+    // a divisor past the newton threshold, quotients from one limb to almost its length
+    big_integer b = pow(big_integer(3), 200000);
+    big_integer r = b - pow(big_integer(5), 130000);
+    for (unsigned digits : {1, 10, 200, 2000, 50000, 90000, 136000})
+    {
+        big_integer q = pow(big_integer(7), digits);
+        big_integer c = b * q + r;
+        EXPECT_EQ(q, c / b);
+        EXPECT_EQ(r, c % b);
+        EXPECT_EQ(q - 1, (c - r - 1) / b);
+        EXPECT_EQ(b - 1, (c - r - 1) % b);
+    }
+}
+
 TEST(correctness, negation_long)
 {
     big_integer a( "10000000000000000000000000000000000000000000000000000");
@@ -679,6 +1188,33 @@ TEST(correctness, string_conv)
     EXPECT_EQ("-2147483649", to_string(lim));
 }
 
+TEST(correctness, string_conv_long)
+{
+    // long enough to be split by powers of ten, the zeros of the lower parts must stay
+    big_integer a = 1;
+    for (size_t i = 0; i != 3000; ++i)
+    {
+        a *= 10;
+    }
+    EXPECT_EQ("1" + std::string(3000, '0'), to_string(a));
+    EXPECT_EQ("-" + std::string(3000, '9'), to_string(1 - a));
+    EXPECT_EQ("7" + std::string(2990, '0') + "1234567891", to_string(a * 7 + 1234567891));
+}
+
+TEST(correctness, ctor_long_string)
+{
+    big_integer a = 1;
+    for (size_t i = 0; i != 3000; ++i)
+    {
+        a *= 10;
+    }
+    EXPECT_EQ(a, big_integer("1" + std::string(3000, '0')));
+    EXPECT_EQ(1 - a, big_integer("-" + std::string(3000, '9')));
+    EXPECT_EQ(a * 7 + 1234567891, big_integer("+000" + std::string(5, '0') + "7" + std::string(2990, '0') + "1234567891"));
+    EXPECT_EQ(0, big_integer("-" + std::string(3000, '0')));
+    EXPECT_THROW(big_integer(std::string(3000, '1') + "x" + std::string(3000, '1')), std::invalid_argument);
+}
+
 namespace
 {
     template <typename T>
@@ -750,3 +1286,293 @@ TEST(correctness, converting_ctor4)
     EXPECT_EQ(to_string(bignum), std::to_string(num));
 }
 
+
+TEST(correctness, int64_overflow)
+{
+    big_integer max = std::numeric_limits<int64_t>::max();
+    big_integer min = std::numeric_limits<int64_t>::min();
+
+    EXPECT_EQ(big_integer("9223372036854775808"), max + 1);
+    EXPECT_EQ(big_integer("-9223372036854775809"), min - 1);
+    EXPECT_EQ(big_integer("9223372036854775808"), -min);
+    EXPECT_EQ(big_integer("9223372036854775808"), min * -1);
+    EXPECT_EQ(big_integer("9223372036854775808"), min / -1);
+    EXPECT_EQ(0, min % -1);
+    EXPECT_EQ(big_integer("85070591730234615847396907784232501249"), max * max);
+    EXPECT_EQ(big_integer("18446744073709551614"), max * 2);
+    EXPECT_EQ(max, (max + 1) - 1);
+    EXPECT_EQ(min, (min - 1) + 1);
+    EXPECT_EQ(max, max * max / max);
+    EXPECT_TRUE(min < max);
+    EXPECT_TRUE(min - 1 < min);
+    EXPECT_TRUE(max < max + 1);
+    EXPECT_TRUE(-max - 1 == min);
+}
+
+namespace
+{
+    template <typename T, typename = void>
+    struct can_add_to : std::false_type
+    {
+    };
+
+    template <typename T>
+    struct can_add_to<T, decltype(void(std::declval<big_integer&>() += std::declval<T>()))> : std::true_type
+    {
+    };
+
+    static_assert(can_add_to<long long>::value && can_add_to<unsigned char>::value, "built-in operands");
+#ifdef __SIZEOF_INT128__
+    // would be cut to 64 bits, so they don't compile
+    __extension__ typedef __int128 int128;
+    __extension__ typedef unsigned __int128 uint128;
+    static_assert(!can_add_to<int128>::value && !can_add_to<uint128>::value, "128-bit operands");
+#endif
+}
+
+TEST(correctness, builtin_operands)
+{
+    big_integer a = -(big_integer(1) << 100) - 12345;
+
+    EXPECT_EQ(big_integer("-1267650600228229401496703217714"), a + 7);
+    EXPECT_EQ(big_integer("-1267650600228229401496703217728"), a - 7u);
+    EXPECT_EQ(big_integer("3802951800684688204490109653163"), a * -3);
+    EXPECT_EQ(big_integer("-126765060022822940149670321772"), a / 10);
+    EXPECT_EQ(-1, a % 10);
+    EXPECT_EQ(big_integer("1267650600228229401496703217726"), 5 - a);
+
+    uint64_t u = std::numeric_limits<uint64_t>::max();
+    EXPECT_EQ(big_integer("-1267650600209782657422993666106"), a + u);
+    EXPECT_EQ(big_integer("-23384026197294446689991306950957354502942632169415"), a * u);
+    EXPECT_EQ(274877906944, a / (-(int64_t(1) << 62)));
+    EXPECT_EQ(-68719489081, a % u);
+    big_integer c("-42391158275216203514294433201");
+    EXPECT_EQ(big_integer("-14910758655419423391"), c % u);
+    EXPECT_EQ(-2298029294, c / u);
+    EXPECT_EQ(976383630u, a.mod_small(1000000007));
+
+    // magnitudes from 2^63 on don't fit the int64_t path
+    uint64_t h = (uint64_t(1) << 63) | 5;
+    int64_t m = std::numeric_limits<int64_t>::min();
+    EXPECT_EQ(big_integer("9223372036854775813"), big_integer(1) * h);
+    EXPECT_EQ(big_integer("-18446744073709551626"), big_integer(-2) * h);
+    EXPECT_EQ(big_integer("-27670116110564327424"), big_integer(3) * m);
+    EXPECT_EQ(big_integer("9223372036854775808"), big_integer(-1) * m);
+    EXPECT_EQ(0, big_integer(0) * m);
+    EXPECT_EQ(0, big_integer(0) * h);
+
+    EXPECT_TRUE(a < 0);
+    EXPECT_TRUE(0 > a);
+    EXPECT_TRUE(a < std::numeric_limits<int64_t>::min());
+    EXPECT_TRUE(-a > u);
+    EXPECT_TRUE(big_integer(u) == u);
+    EXPECT_TRUE(u != big_integer(u) - 1);
+    EXPECT_TRUE(big_integer(-5) <= -5L);
+    EXPECT_TRUE(big_integer(-5) >= -5LL);
+    EXPECT_FALSE(big_integer(-5) == 5u);
+
+    EXPECT_THROW(a / 0, std::overflow_error);
+    EXPECT_THROW(a % 0u, std::overflow_error);
+    EXPECT_THROW(a.mod_small(0), std::overflow_error);
+}
+
+namespace
+{
+    std::atomic<size_t> allocations(0);
+}
+
+// counts heap allocations for the tests below
+void* operator new(std::size_t size)
+{
+    ++allocations;
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+// gcc inlines these into callers that got the pointer from operator new and takes the pair for
+// mismatched, though the replacement above does allocate by malloc
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+TEST(correctness, move)
+{
+    big_integer a("123456789012345678901234567890");
+    big_integer b(std::move(a));
+    EXPECT_EQ(big_integer("123456789012345678901234567890"), b);
+    EXPECT_EQ(0, a);
+
+    a = std::move(b);
+    EXPECT_EQ(big_integer("123456789012345678901234567890"), a);
+    EXPECT_EQ(0, b);
+
+    a = std::move(a);
+    EXPECT_EQ(big_integer("123456789012345678901234567890"), a);
+}
+
+TEST(correctness, rvalue_operators)
+{
+    big_integer a("-98765432109876543210987654321");
+    big_integer b("12345678901234567890");
+
+    EXPECT_EQ(big_integer("-98765432097530864309753086431"), a + big_integer(b));
+    EXPECT_EQ(big_integer("-98765432122222222112222222211"), a - big_integer(b));
+    EXPECT_EQ(big_integer("98765432122222222112222222211"), b - big_integer(a));
+    EXPECT_EQ(a & b, a & big_integer(b));
+    EXPECT_EQ(a | b, a | big_integer(b));
+    EXPECT_EQ(a ^ b, a ^ big_integer(b));
+    EXPECT_EQ(big_integer("98765432109876543210987654321"), -big_integer(a));
+}
+
+#ifdef BIG_INTEGER_STATS
+TEST(correctness, stats)
+{
+    big_integer a = (big_integer(1) << 100000) - 1;
+    big_integer b = (big_integer(1) << 3000) - 1;
+
+    reset_stats();
+    big_integer c = a * b;
+    big_integer_stats s = get_stats();
+    // 1563 and 47 limbs
+    EXPECT_EQ(1u, s.mul_longer[11]);
+    EXPECT_EQ(1u, s.mul_shorter[6]);
+    EXPECT_EQ(1u, s.tiers[big_integer_stats::MUL_UNBALANCED]);
+    EXPECT_GT(s.tiers[big_integer_stats::MUL_BASECASE], 0u);
+    EXPECT_EQ(0u, s.tiers[big_integer_stats::MUL_NTT]);
+    EXPECT_GT(s.allocations[big_integer_stats::MUL], 0u);
+    EXPECT_GE(s.allocated_bytes[big_integer_stats::MUL], 1610 * 8u);
+    EXPECT_EQ(0u, s.allocations[big_integer_stats::DIV]);
+
+    c /= b;
+    s = get_stats();
+    EXPECT_EQ(a, c);
+    EXPECT_EQ(1u, s.div_dividend[11]);
+    EXPECT_EQ(1u, s.div_divisor[6]);
+    EXPECT_GT(s.tiers[big_integer_stats::DIV_SCHOOLBOOK] + s.tiers[big_integer_stats::DIV_RECURSIVE], 0u);
+
+    reset_stats();
+    s = get_stats();
+    EXPECT_EQ(0u, s.mul_longer[11]);
+    EXPECT_EQ(0u, s.allocations[big_integer_stats::MUL]);
+
+    // counters of a finished thread are kept
+    std::thread([&b] { big_integer d = b * b; }).join();
+    s = get_stats();
+    EXPECT_EQ(2u, s.mul_shorter[6] + s.mul_longer[6]);
+    EXPECT_EQ(1u, s.tiers[big_integer_stats::SQR_BASECASE]);
+}
+
+TEST(correctness, stats_exit_with_threads)
+{
+    // the workers of the pool finish while static objects are destroyed, their counters must
+    // still have somewhere to go
+    testing::FLAGS_gtest_death_test_style = "threadsafe";
+    EXPECT_EXIT(
+        {
+            set_multiplication_threads(4);
+            set_parallel_threshold(50);
+            big_integer a = (big_integer(1) << 100000) - 1;
+            big_integer c = a * a;
+            std::exit(c > a ? 0 : 1);
+        },
+        testing::ExitedWithCode(0), "");
+}
+#endif
+
+TEST(correctness, sum_chain_allocations)
+{
+    // temporaries of a chain pass their limbs on, only the result is allocated
+    big_integer a = big_integer(1) << 200;
+    big_integer b("12345678901234567890123");
+    big_integer c("98765432109876543210");
+
+    size_t before = allocations;
+    big_integer d = a + b + c + b - c;
+    EXPECT_EQ(1u, allocations - before);
+
+    before = allocations;
+    big_integer e = b - (a + c) - a;
+    EXPECT_EQ(1u, allocations - before);
+
+    before = allocations;
+    big_integer f = -(a - b);
+    EXPECT_EQ(1u, allocations - before);
+
+    EXPECT_EQ(a + b * 2, d);
+    EXPECT_EQ(b - c - a * 2, e);
+    EXPECT_EQ(b - a, f);
+}
+
+TEST(correctness, small_values_allocations)
+{
+    // up to two limbs (128 bits) are kept in place
+    size_t before = allocations;
+    big_integer a = 0;
+    for (int i = 0; i != 1000; ++i)
+    {
+        a += i;
+        a -= 1;
+    }
+    big_integer b = a * a * 12345;
+    big_integer c = b / 7 % 1000;
+    big_integer d = b << 60;
+    EXPECT_EQ(0u, allocations - before);
+
+    EXPECT_EQ(498500, a);
+    EXPECT_EQ(big_integer("3067760276250000"), b);
+    EXPECT_EQ(714, c);
+    EXPECT_EQ(big_integer("3536886793467266526735237120000000"), d);
+}
+
+TEST(correctness, builtin_operands_allocations)
+{
+    // built-in operands don't make a big_integer of their own
+    big_integer a = big_integer(1) << 200;
+    big_integer b = a;
+    uint64_t u = std::numeric_limits<uint64_t>::max();
+    size_t before = allocations;
+    for (int i = 0; i != 100; ++i)
+    {
+        ++a;
+        a *= 3u;
+        a /= 3;
+        a -= 1L;
+        EXPECT_EQ(a, b);
+        EXPECT_TRUE(a.mod_small(7) == 4 && a > u);
+    }
+    EXPECT_EQ(0u, allocations - before);
+}